@@ -9,6 +9,8 @@ public:
     virtual ~AbstractTexture() = default;
 
     virtual void bind(int textureUnit = 0) const = 0;
+    // Brings pending changes to the GL texture, which may change the binding of the active unit
+    virtual void upload() const {}
 };
 
 } // namespace muui
@@ -0,0 +1,33 @@
+#include "animator.h"
+
+#include "system.h"
+
+namespace muui
+{
+
+Animator::Animator() = default;
+Animator::~Animator() = default;
+
+void Animator::update(float elapsed)
+{
+    if (activeCount() == 0)
+        return;
+    if (elapsed > 0.0f)
+    {
+        // groups created by the handlers of value changes are appended
+        for (std::size_t i = 0; i < m_groups.size(); ++i)
+            m_groups[i].second->update(elapsed);
+    }
+    // the new values need to be drawn, and even frames too short to step the animations need a next one
+    sys::requestUpdate();
+}
+
+std::size_t Animator::activeCount() const
+{
+    std::size_t count = 0;
+    for (const auto &group : m_groups)
+        count += group.second->activeCount();
+    return count;
+}
+
+} // namespace muui
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace muui
+{
+template<typename F>
+class ValueAnimation;
+
+// Advances the running animations once per frame, see sys::animator(). Animations are registered while they run, in
+// arrays grouped by tweening function, so that a frame evaluates each group in a single loop and the cost depends on
+// the number of running animations only.
+class Animator : private NonCopyable
+{
+public:
+    Animator();
+    ~Animator();
+
+    // Advances the running animations and emits their value changes, asks for another frame while any is running
+    void update(float elapsed);
+    std::size_t activeCount() const;
+
+private:
+    class AnimationGroup
+    {
+    public:
+        virtual ~AnimationGroup() = default;
+        virtual void update(float elapsed) = 0;
+        virtual std::size_t activeCount() const = 0;
+    };
+
+    template<typename F>
+    class TweenGroup;
+
+    template<typename F>
+    TweenGroup<F> *group();
+
+    template<typename F>
+    static inline const char GroupKey = 0;
+
+    std::vector<std::pair<const void *, std::unique_ptr<AnimationGroup>>> m_groups;
+
+    template<typename F>
+    friend class ValueAnimation;
+};
+
+template<typename F>
+class Animator::TweenGroup : public AnimationGroup
+{
+public:
+    using T = typename F::Type;
+
+    ~TweenGroup() override
+    {
+        for (auto *animation : m_animations)
+        {
+            if (animation)
+            {
+                animation->m_group = nullptr;
+                animation->m_active = false;
+            }
+        }
+    }
+
+    void add(ValueAnimation<F> *animation)
+    {
+        animation->m_group = this;
+        animation->m_slot = m_animations.size();
+        m_animations.push_back(animation);
+        m_time.push_back(T{0});
+        m_duration.push_back(animation->duration);
+        m_start.push_back(animation->startValue);
+        m_end.push_back(animation->endValue);
+        m_value.push_back(animation->startValue);
+    }
+
+    void restart(std::size_t slot)
+    {
+        if (m_updating)
+        {
+            // the values of this frame are already computed, so it's advanced from the next frame like a new one
+            auto *animation = m_animations[slot];
+            remove(slot);
+            add(animation);
+            return;
+        }
+        const auto *animation = m_animations[slot];
+        m_time[slot] = T{0};
+        m_duration[slot] = animation->duration;
+        m_start[slot] = animation->startValue;
+        m_end[slot] = animation->endValue;
+    }
+
+    void remove(std::size_t slot)
+    {
+        m_animations[slot]->m_group = nullptr;
+        if (m_updating)
+        {
+            // the slots are compacted once the update is done
+            m_animations[slot] = nullptr;
+            return;
+        }
+        moveSlot(m_animations.size() - 1, slot);
+        resize(m_animations.size() - 1);
+    }
+
+    void update(float elapsed) override
+    {
+        const auto count = m_animations.size();
+        for (std::size_t i = 0; i < count; ++i)
+            m_time[i] = std::min(m_time[i] + elapsed, m_duration[i]);
+        constexpr F tweener;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto t = m_duration[i] > T{0} ? m_time[i] / m_duration[i] : T{1};
+            m_value[i] = glm::mix(m_start[i], m_end[i], tweener(t));
+        }
+
+        // handlers can start, stop and destroy animations, the ones they start are advanced from the next frame
+        m_updating = true;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto *animation = m_animations[i];
+            if (!animation)
+                continue;
+            const auto value = m_value[i];
+            const bool finished = m_time[i] >= m_duration[i];
+            animation->m_t = m_time[i];
+            if (finished)
+                animation->m_active = false;
+            animation->valueChangedSignal(value);
+            // unless a handler stopped, restarted or destroyed it meanwhile
+            if (finished && m_animations[i] == animation)
+            {
+                remove(i);
+                animation->finishedSignal();
+            }
+        }
+        m_updating = false;
+        compact();
+    }
+
+    std::size_t activeCount() const override
+    {
+        return std::count_if(m_animations.begin(), m_animations.end(), [](auto *animation) { return animation; });
+    }
+
+private:
+    void moveSlot(std::size_t from, std::size_t to)
+    {
+        if (from == to)
+            return;
+        m_animations[to] = m_animations[from];
+        m_animations[to]->m_slot = to;
+        m_time[to] = m_time[from];
+        m_duration[to] = m_duration[from];
+        m_start[to] = m_start[from];
+        m_end[to] = m_end[from];
+        m_value[to] = m_value[from];
+    }
+
+    void resize(std::size_t size)
+    {
+        m_animations.resize(size);
+        m_time.resize(size);
+        m_duration.resize(size);
+        m_start.resize(size);
+        m_end.resize(size);
+        m_value.resize(size);
+    }
+
+    void compact()
+    {
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < m_animations.size(); ++i)
+        {
+            if (m_animations[i])
+                moveSlot(i, size++);
+        }
+        resize(size);
+    }
+
+    std::vector<ValueAnimation<F> *> m_animations;
+    std::vector<T> m_time;
+    std::vector<T> m_duration;
+    std::vector<T> m_start;
+    std::vector<T> m_end;
+    std::vector<T> m_value;
+    bool m_updating = false;
+};
+
+template<typename F>
+Animator::TweenGroup<F> *Animator::group()
+{
+    const void *key = &GroupKey<F>;
+    auto it = std::find_if(m_groups.begin(), m_groups.end(), [key](const auto &group) { return group.first == key; });
+    if (it == m_groups.end())
+    {
+        m_groups.emplace_back(key, std::make_unique<TweenGroup<F>>());
+        it = std::prev(m_groups.end());
+    }
+    return static_cast<TweenGroup<F> *>(it->second.get());
+}
+
+} // namespace muui
@@ -2,17 +2,75 @@
 #include <emscripten.h>
 #endif
 
+#if defined(__ANDROID__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 #include "application.h"
 
+#include "animator.h"
+#include "fontcache.h"
+#include "framedamage.h"
 #include "gl.h"
 #include "log.h"
+#include "statecache.h"
 #include "system.h"
 
 #include <cassert>
+#include <cstring>
 
 namespace muui
 {
 
+namespace
+{
+
+#if defined(__ANDROID__)
+PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC s_eglSwapBuffersWithDamage = nullptr;
+
+void resolveSwapWithDamage()
+{
+    s_eglSwapBuffersWithDamage = nullptr;
+    auto *display = eglGetCurrentDisplay();
+    const auto *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions)
+        return;
+    if (std::strstr(extensions, "EGL_KHR_swap_buffers_with_damage"))
+    {
+        s_eglSwapBuffersWithDamage =
+            reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    }
+    else if (std::strstr(extensions, "EGL_EXT_swap_buffers_with_damage"))
+    {
+        s_eglSwapBuffersWithDamage =
+            reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+}
+#endif
+
+// Lets the compositor know which part of the window changed, where the platform supports it
+void swapWindow(SDL_Window *window, [[maybe_unused]] const FrameDamage &damage)
+{
+#if defined(__ANDROID__)
+    if (s_eglSwapBuffersWithDamage && damage.tracked && !damage.full)
+    {
+        int height = 0;
+        SDL_GL_GetDrawableSize(window, nullptr, &height);
+        // an empty damage list means the whole surface, so always pass at least an empty rectangle
+        const auto rect = damage.rect.value_or(RectF{});
+        // origin in the bottom left corner, like GL
+        EGLint rects[] = {static_cast<EGLint>(rect.min.x), static_cast<EGLint>(height - rect.max.y),
+                          static_cast<EGLint>(rect.width()), static_cast<EGLint>(rect.height())};
+        s_eglSwapBuffersWithDamage(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), rects, 1);
+        return;
+    }
+#endif
+    SDL_GL_SwapWindow(window);
+}
+
+} // namespace
+
 Application::Application() = default;
 
 Application::~Application()
@@ -101,6 +159,10 @@ bool Application::createWindow(int width, int height, const char *title, WindowF
 
     SDL_GL_SetSwapInterval(flags.testFlag(WindowFlag::VSync) ? 1 : 0);
 
+#if defined(__ANDROID__)
+    resolveSwapWithDamage();
+#endif
+
     if (!initialize())
         return false;
 
@@ -138,81 +200,57 @@ void Application::exec()
 void Application::updateAndRender()
 {
     SDL_Event event;
-    while (SDL_PollEvent(&event))
+    bool waited = false;
+#if !defined(__EMSCRIPTEN__)
+    // requests made while the last frame was rendered, or from other threads, are still pending
+    if (m_renderOnDemand && !sys::updateRequested())
     {
-        switch (event.type)
-        {
-        case SDL_WINDOWEVENT: {
-            switch (event.window.event)
-            {
-            case SDL_WINDOWEVENT_RESIZED: {
-                const auto width = event.window.data1;
-                const auto height = event.window.data2;
-                log_info("Window resized to {}x{}", width, height);
-                resize(width, height);
-                break;
-            }
-            break;
-            }
-            break;
-        }
-        case SDL_RENDER_DEVICE_RESET: {
-            recreateGLContext();
-            break;
-        }
-        case SDL_MOUSEBUTTONDOWN: {
-            if (event.button.button == SDL_BUTTON_LEFT && event.button.state == SDL_PRESSED)
-                handleTouchEvent(TouchAction::Down, event.button.x, event.button.y);
-            break;
-        }
-        case SDL_MOUSEBUTTONUP: {
-            if (event.button.button == SDL_BUTTON_LEFT && event.button.state == SDL_RELEASED)
-                handleTouchEvent(TouchAction::Up, event.button.x, event.button.y);
-            break;
-        }
-        case SDL_MOUSEMOTION: {
-            if (event.button.button & SDL_BUTTON_LMASK)
-                handleTouchEvent(TouchAction::Move, event.motion.x, event.motion.y);
-            break;
-        }
-        case SDL_KEYDOWN: {
-            const SDL_Keycode key = event.key.keysym.sym;
-            switch (key)
-            {
-            case SDLK_ESCAPE:
-                m_running = false;
-                break;
-            default:
-                handleKeyPress(event.key.keysym);
-                break;
-            }
-            break;
-        }
-        case SDL_TEXTINPUT: {
-            handleTextInputEvent(event.text.text); // utf-8 encoded
-            break;
-        }
-        case SDL_QUIT:
-            m_running = false;
-            break;
-        default:
-            break;
-        }
+        if (sys::waitEvent(&event, m_idleTimeout))
+            handleEvent(event);
+        waited = true;
     }
+#endif
+    while (SDL_PollEvent(&event))
+        handleEvent(event);
+
+    // frames can take less than a millisecond
+    const Uint64 counter = SDL_GetPerformanceCounter();
+
+    // time spent idle doesn't count, animations started by the events that woke us up should start from the beginning
+    if (m_lastUpdate == ~Uint64(0) || waited)
+        m_lastUpdate = counter;
+    const auto elapsed = static_cast<float>(static_cast<double>(counter - m_lastUpdate) /
+                                            static_cast<double>(SDL_GetPerformanceFrequency()));
+    m_lastUpdate = counter;
+    sys::animator()->update(elapsed);
+    update(elapsed);
 
-    const Uint32 now = SDL_GetTicks();
+    // taken right before rendering, so that whatever is requested from now on gets the next frame
+    const bool updateRequested = sys::takeUpdateRequest();
+    if (m_renderOnDemand && !updateRequested)
+        return;
 
-    if (m_lastUpdate == ~0u)
-        m_lastUpdate = now;
-    const auto elapsed = static_cast<float>(now - m_lastUpdate) / 1000.0f;
-    m_lastUpdate = now;
-    update(elapsed);
+    // the application may have changed GL state directly since the last frame
+    gl::stateCache().invalidate();
 
+    // glyphs rasterized in the background since the last frame
+    sys::fontCache()->commitPreloadedGlyphs();
+
+    auto *renderStats = sys::renderStats();
+    *renderStats = {};
+    auto *frameDamage = sys::frameDamage();
+    *frameDamage = {};
     render();
-    SDL_GL_SwapWindow(m_window);
+    m_renderStats = *renderStats;
+    swapWindow(m_window, *frameDamage);
+
+    // the next step of the running animations needs another frame
+    if (sys::animator()->activeCount() != 0)
+        sys::requestUpdate();
 
     ++m_frameCount;
 
+    const Uint32 now = SDL_GetTicks();
     if (m_frameCountStart == ~0u)
         m_frameCountStart = now;
     if (now - m_frameCountStart >= 5000)
@@ -224,6 +262,78 @@ void Application::updateAndRender()
     }
 }
 
+void Application::handleEvent(const SDL_Event &event)
+{
+    switch (event.type)
+    {
+    case SDL_WINDOWEVENT: {
+        switch (event.window.event)
+        {
+        case SDL_WINDOWEVENT_RESIZED: {
+            const auto width = event.window.data1;
+            const auto height = event.window.data2;
+            log_info("Window resized to {}x{}", width, height);
+            resize(width, height);
+            sys::requestUpdate();
+            break;
+        }
+        case SDL_WINDOWEVENT_EXPOSED: {
+            sys::requestUpdate();
+            break;
+        }
+        break;
+        }
+        break;
+    }
+    case SDL_RENDER_DEVICE_RESET: {
+        recreateGLContext();
+        break;
+    }
+    case SDL_MOUSEBUTTONDOWN: {
+        if (event.button.button == SDL_BUTTON_LEFT && event.button.state == SDL_PRESSED)
+            handleTouchEvent(TouchAction::Down, event.button.x, event.button.y);
+        break;
+    }
+    case SDL_MOUSEBUTTONUP: {
+        if (event.button.button == SDL_BUTTON_LEFT && event.button.state == SDL_RELEASED)
+            handleTouchEvent(TouchAction::Up, event.button.x, event.button.y);
+        break;
+    }
+    case SDL_MOUSEMOTION: {
+        if (event.button.button & SDL_BUTTON_LMASK)
+            handleTouchEvent(TouchAction::Move, event.motion.x, event.motion.y);
+        break;
+    }
+    case SDL_KEYDOWN: {
+        const SDL_Keycode key = event.key.keysym.sym;
+        switch (key)
+        {
+        case SDLK_ESCAPE:
+            m_running = false;
+            break;
+        default:
+            handleKeyPress(event.key.keysym);
+            break;
+        }
+        break;
+    }
+    case SDL_TEXTINPUT: {
+        handleTextInputEvent(event.text.text); // utf-8 encoded
+        break;
+    }
+    case SDL_QUIT:
+        m_running = false;
+        break;
+    default:
+        break;
+    }
+}
+
+void Application::requestUpdate()
+{
+    sys::requestUpdate();
+}
+
 void Application::quit()
 {
     m_running = false;
@@ -240,7 +350,12 @@ void Application::handleTextInputEvent(std::string_view) {}
 void Application::recreateGLContext()
 {
     m_context = SDL_GL_CreateContext(m_window);
+    gl::stateCache().invalidate();
+#if defined(__ANDROID__)
+    resolveSwapWithDamage();
+#endif
     m_contextRecreatedSignal();
+    sys::requestUpdate();
     log_info("GL context recreated!");
 }
 
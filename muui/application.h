@@ -2,6 +2,7 @@
 
 #include "flags.h"
 #include "noncopyable.h"
+#include "renderstats.h"
 #include "uiinput.h"
 
 #include <muslots/muslots.h>
@@ -36,7 +37,18 @@ public:
 
     muslots::Signal<> &contextRecreatedEvent() { return m_contextRecreatedSignal; }
 
+    // Waits for events instead of rendering frames nobody asked for. A frame is rendered when an item is invalidated, an
+    // animation is running or requestUpdate() is called. The time spent waiting isn't included in the elapsed time
+    // passed to update(), which is still called at least every idleTimeout milliseconds.
+    void setRenderOnDemand(bool enabled) { m_renderOnDemand = enabled; }
+    bool renderOnDemand() const { return m_renderOnDemand; }
+    void setIdleTimeout(int milliseconds) { m_idleTimeout = milliseconds; }
+    int idleTimeout() const { return m_idleTimeout; }
+    void requestUpdate();
+
     float framesPerSecond() const { return m_fps; }
+    // What it took to render the last frame
+    const RenderStats &renderStats() const { return m_renderStats; }
     void updateAndRender();
 
 protected:
@@ -50,16 +62,20 @@ protected:
 
 private:
     void recreateGLContext();
+    void handleEvent(const SDL_Event &event);
 
     SDL_Window *m_window = nullptr;
     SDL_GLContext m_context = nullptr;
     bool m_initialized = false;
     muslots::Signal<> m_contextRecreatedSignal;
     bool m_running = false;
-    Uint32 m_lastUpdate = ~0u;
+    bool m_renderOnDemand = false;
+    int m_idleTimeout = 1000;
+    Uint64 m_lastUpdate = ~Uint64(0);
     float m_fps = 0.0f;
     Uint32 m_frameCountStart = ~0u;
     int m_frameCount = 0;
+    RenderStats m_renderStats;
 };
 
 } // namespace muui
@@ -1,11 +1,11 @@
 precision highp float;
 
-uniform sampler2D baseColorTexture;
+#include "sprite.inc.frag"
 
 in vec2 vs_texCoord;
 out vec4 fragColor;
 
 void main(void)
 {
-    fragColor = texture(baseColorTexture, vs_texCoord);
+    fragColor = sampleBaseColor(vs_texCoord);
 }
@@ -1,5 +1,4 @@
-layout(location=0) in vec2 position;
-layout(location=1) in vec2 texCoord;
+#include "sprite.inc.vert"
 
 uniform mat4 mvp;
 
@@ -7,6 +6,7 @@ out vec2 vs_texCoord;
 
 void main(void)
 {
-    vs_texCoord = texCoord;
-    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    forwardSpriteData();
+    vs_texCoord = spriteTexCoord();
+    gl_Position = mvp * vec4(spritePosition(), spriteDepth(), 1.0);
 }
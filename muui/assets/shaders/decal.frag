@@ -1,6 +1,6 @@
 precision highp float;
 
-uniform sampler2D baseColorTexture;
+#include "sprite.inc.frag"
 
 in vec2 vs_texCoord;
 in vec4 vs_color;
@@ -8,7 +8,7 @@ out vec4 fragColor;
 
 void main(void)
 {
-    vec4 baseColor = texture(baseColorTexture, vs_texCoord);
+    vec4 baseColor = sampleBaseColor(vs_texCoord);
     vec4 color = baseColor * vs_color;
     color.rgb *= color.a; // premultiply alpha
     fragColor = color;
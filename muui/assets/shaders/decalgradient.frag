@@ -1,6 +1,6 @@
 precision highp float;
 
-uniform sampler2D baseColorTexture;
+#include "sprite.inc.frag"
 
 in vec2 vs_position;
 in vec2 vs_texCoord;
@@ -10,7 +10,7 @@ out vec4 fragColor;
 
 void main(void)
 {
-    vec4 baseColor = texture(baseColorTexture, vs_texCoord);
+    vec4 baseColor = sampleBaseColor(vs_texCoord);
     vec4 color = baseColor * gradientColor(vs_position);
     color.rgb *= color.a; // premultiply alpha
     fragColor = color;
@@ -1,5 +1,4 @@
-layout(location=0) in vec2 position;
-layout(location=2) in vec4 color;
+#include "sprite.inc.vert"
 
 uniform mat4 mvp;
 
@@ -7,6 +6,6 @@ out vec4 vs_color;
 
 void main(void)
 {
-    vs_color = color;
-    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    vs_color = spriteFgColor();
+    gl_Position = mvp * vec4(spritePosition(), spriteDepth(), 1.0);
 }
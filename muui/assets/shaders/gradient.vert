@@ -1,5 +1,4 @@
-layout(location=0) in vec2 position;
-layout(location=2) in vec4 gradientFromTo;
+#include "sprite.inc.vert"
 
 uniform mat4 mvp;
 
@@ -9,8 +8,10 @@ out vec2 vs_gradientTo;
 
 void main(void)
 {
+    vec2 position = spritePosition();
+    vec4 gradientFromTo = spriteFgColor();
     vs_position = position;
     vs_gradientFrom = gradientFromTo.xy;
     vs_gradientTo = gradientFromTo.zw;
-    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    gl_Position = mvp * vec4(position, spriteDepth(), 1.0);
 }
@@ -1,7 +1,4 @@
-layout(location=0) in vec2 position;
-layout(location=1) in vec2 texCoord;
-layout(location=2) in vec4 fgColor;
-layout(location=3) in vec4 bgColor;
+#include "sprite.inc.vert"
 
 uniform mat4 mvp;
 
@@ -12,9 +9,10 @@ out float vs_cornerRadius;
 
 void main(void)
 {
-    vs_texCoord = texCoord;
-    vs_color = fgColor;
+    vec4 bgColor = spriteBgColor();
+    vs_texCoord = spriteTexCoord();
+    vs_color = spriteFgColor();
     vs_size = bgColor.xy;
     vs_cornerRadius = bgColor.z;
-    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    gl_Position = mvp * vec4(spritePosition(), spriteDepth(), 1.0);
 }
@@ -1,7 +1,4 @@
-layout(location=0) in vec2 position;
-layout(location=1) in vec2 texCoord;
-layout(location=2) in vec4 gradientFromTo;
-layout(location=3) in vec4 bgColor;
+#include "sprite.inc.vert"
 
 uniform mat4 mvp;
 
@@ -14,11 +11,14 @@ out float vs_cornerRadius;
 
 void main(void)
 {
-    vs_texCoord = texCoord;
+    vec2 position = spritePosition();
+    vec4 gradientFromTo = spriteFgColor();
+    vec4 bgColor = spriteBgColor();
+    vs_texCoord = spriteTexCoord();
     vs_position = position;
     vs_gradientFrom = gradientFromTo.xy;
     vs_gradientTo = gradientFromTo.zw;
     vs_size = bgColor.xy;
     vs_cornerRadius = bgColor.z;
-    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    gl_Position = mvp * vec4(position, spriteDepth(), 1.0);
 }
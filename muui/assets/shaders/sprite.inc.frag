@@ -0,0 +1,39 @@
+#ifdef MULTI_TEXTURE
+uniform sampler2D baseColorTextures[MAX_BATCH_TEXTURES];
+
+flat in int vs_textureIndex;
+
+vec4 sampleBaseColor(vec2 texCoord)
+{
+    // Sampler arrays can only be indexed with constant expressions in GLSL ES 3.00. The gradients are computed
+    // outside of the branches, which are not uniform across primitives.
+    vec2 dx = dFdx(texCoord);
+    vec2 dy = dFdy(texCoord);
+    switch (vs_textureIndex)
+    {
+    case 0:
+        return textureGrad(baseColorTextures[0], texCoord, dx, dy);
+    case 1:
+        return textureGrad(baseColorTextures[1], texCoord, dx, dy);
+    case 2:
+        return textureGrad(baseColorTextures[2], texCoord, dx, dy);
+    case 3:
+        return textureGrad(baseColorTextures[3], texCoord, dx, dy);
+    case 4:
+        return textureGrad(baseColorTextures[4], texCoord, dx, dy);
+    case 5:
+        return textureGrad(baseColorTextures[5], texCoord, dx, dy);
+    case 6:
+        return textureGrad(baseColorTextures[6], texCoord, dx, dy);
+    default:
+        return textureGrad(baseColorTextures[7], texCoord, dx, dy);
+    }
+}
+#else
+uniform sampler2D baseColorTexture;
+
+vec4 sampleBaseColor(vec2 texCoord)
+{
+    return texture(baseColorTexture, texCoord);
+}
+#endif
@@ -0,0 +1,76 @@
+#ifdef INSTANCED
+layout(location=0) in vec2 vertexCorner; // unit quad
+layout(location=1) in vec4 instanceTexRect;
+layout(location=2) in vec4 instanceFgColor;
+layout(location=3) in vec4 instanceBgColor;
+layout(location=4) in vec4 instanceRect;
+layout(location=5) in vec4 instanceTransform; // 2x2 linear part, column-major
+layout(location=6) in vec2 instanceTranslation;
+
+vec2 spritePosition()
+{
+    vec2 p = mix(instanceRect.xy, instanceRect.zw, vertexCorner);
+    return mat2(instanceTransform.xy, instanceTransform.zw) * p + instanceTranslation;
+}
+
+vec2 spriteTexCoord()
+{
+    return mix(instanceTexRect.xy, instanceTexRect.zw, vertexCorner);
+}
+
+vec4 spriteFgColor()
+{
+    return instanceFgColor;
+}
+
+vec4 spriteBgColor()
+{
+    return instanceBgColor;
+}
+#else
+layout(location=0) in vec2 position;
+layout(location=1) in vec2 texCoord;
+layout(location=2) in vec4 fgColor;
+layout(location=3) in vec4 bgColor;
+
+vec2 spritePosition()
+{
+    return position;
+}
+
+vec2 spriteTexCoord()
+{
+    return texCoord;
+}
+
+vec4 spriteFgColor()
+{
+    return fgColor;
+}
+
+vec4 spriteBgColor()
+{
+    return bgColor;
+}
+#endif
+
+layout(location=7) in float vertexDepth; // constant 0 when depth testing is disabled
+
+float spriteDepth()
+{
+    return vertexDepth;
+}
+
+#ifdef MULTI_TEXTURE
+layout(location=8) in float vertexTextureIndex;
+
+flat out int vs_textureIndex;
+#endif
+
+// Passes the per-sprite data that is only used by the fragment shader through
+void forwardSpriteData()
+{
+#ifdef MULTI_TEXTURE
+    vs_textureIndex = int(vertexTextureIndex);
+#endif
+}
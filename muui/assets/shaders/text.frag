@@ -1,6 +1,6 @@
 precision highp float;
 
-uniform sampler2D baseColorTexture;
+#include "sprite.inc.frag"
 
 in vec2 vs_texCoord;
 in vec4 vs_color;
@@ -8,7 +8,7 @@ out vec4 fragColor;
 
 void main(void)
 {
-    float alpha = texture(baseColorTexture, vs_texCoord).r;
+    float alpha = sampleBaseColor(vs_texCoord).r;
     vec4 color = vs_color;
     color.a *= alpha;
     color.rgb *= color.a; // premultiply alpha
@@ -1,6 +1,4 @@
-layout(location=0) in vec2 position;
-layout(location=1) in vec2 texCoord;
-layout(location=2) in vec4 color;
+#include "sprite.inc.vert"
 
 uniform mat4 mvp;
 
@@ -9,7 +7,8 @@ out vec4 vs_color;
 
 void main(void)
 {
-    vs_texCoord = texCoord;
-    vs_color = color;
-    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    forwardSpriteData();
+    vs_texCoord = spriteTexCoord();
+    vs_color = spriteFgColor();
+    gl_Position = mvp * vec4(spritePosition(), spriteDepth(), 1.0);
 }
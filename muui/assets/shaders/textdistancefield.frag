@@ -0,0 +1,20 @@
+precision highp float;
+
+#include "sprite.inc.frag"
+
+in vec2 vs_texCoord;
+in vec4 vs_color;
+in float vs_edge;
+out vec4 fragColor;
+
+void main(void)
+{
+    float distance = sampleBaseColor(vs_texCoord).r;
+    // antialias over about one screen pixel, whatever the scale the glyph is drawn at
+    float smoothing = 0.7 * fwidth(distance);
+    float alpha = smoothstep(vs_edge - smoothing, vs_edge + smoothing, distance);
+    vec4 color = vs_color;
+    color.a *= alpha;
+    color.rgb *= color.a; // premultiply alpha
+    fragColor = color;
+}
@@ -0,0 +1,16 @@
+#include "sprite.inc.vert"
+
+uniform mat4 mvp;
+
+out vec2 vs_texCoord;
+out vec4 vs_color;
+out float vs_edge;
+
+void main(void)
+{
+    forwardSpriteData();
+    vs_texCoord = spriteTexCoord();
+    vs_color = spriteFgColor();
+    vs_edge = spriteBgColor().x;
+    gl_Position = mvp * vec4(spritePosition(), spriteDepth(), 1.0);
+}
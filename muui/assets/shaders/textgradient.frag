@@ -1,6 +1,6 @@
 precision highp float;
 
-uniform sampler2D baseColorTexture;
+#include "sprite.inc.frag"
 
 in vec2 vs_texCoord;
 in vec2 vs_position;
@@ -11,7 +11,7 @@ out vec4 fragColor;
 void main(void)
 {
     vec4 color = gradientColor(vs_position);
-    float alpha = texture(baseColorTexture, vs_texCoord).r;
+    float alpha = sampleBaseColor(vs_texCoord).r;
     color.a *= alpha;
     color.rgb *= color.a; // premultiply alpha
     fragColor = color;
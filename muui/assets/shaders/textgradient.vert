@@ -1,19 +1,20 @@
-layout(location=0) in vec2 position;
-layout(location=1) in vec2 texCoord;
-layout(location=2) in vec4 gradientFromTo;
+#include "sprite.inc.vert"
 
 uniform mat4 mvp;
 
-out vec2 vs_texCoord;
 out vec2 vs_position;
+out vec2 vs_texCoord;
 out vec2 vs_gradientFrom;
 out vec2 vs_gradientTo;
 
 void main(void)
 {
+    forwardSpriteData();
+    vec2 position = spritePosition();
+    vec4 gradientFromTo = spriteFgColor();
     vs_position = position;
-    vs_texCoord = texCoord;
+    vs_texCoord = spriteTexCoord();
     vs_gradientFrom = gradientFromTo.xy;
     vs_gradientTo = gradientFromTo.zw;
-    gl_Position = mvp * vec4(position, 0.0, 1.0);
+    gl_Position = mvp * vec4(position, spriteDepth(), 1.0);
 }
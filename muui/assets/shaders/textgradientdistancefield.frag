@@ -0,0 +1,20 @@
+precision highp float;
+
+#include "sprite.inc.frag"
+
+in vec2 vs_texCoord;
+in vec2 vs_position;
+in float vs_edge;
+out vec4 fragColor;
+
+#include "lineargradient.inc.frag"
+
+void main(void)
+{
+    vec4 color = gradientColor(vs_position);
+    float distance = sampleBaseColor(vs_texCoord).r;
+    float smoothing = 0.7 * fwidth(distance);
+    color.a *= smoothstep(vs_edge - smoothing, vs_edge + smoothing, distance);
+    color.rgb *= color.a; // premultiply alpha
+    fragColor = color;
+}
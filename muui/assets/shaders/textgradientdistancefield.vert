@@ -0,0 +1,22 @@
+#include "sprite.inc.vert"
+
+uniform mat4 mvp;
+
+out vec2 vs_position;
+out vec2 vs_texCoord;
+out vec2 vs_gradientFrom;
+out vec2 vs_gradientTo;
+out float vs_edge;
+
+void main(void)
+{
+    forwardSpriteData();
+    vec2 position = spritePosition();
+    vec4 gradientFromTo = spriteFgColor();
+    vs_position = position;
+    vs_texCoord = spriteTexCoord();
+    vs_gradientFrom = gradientFromTo.xy;
+    vs_gradientTo = gradientFromTo.zw;
+    vs_edge = spriteBgColor().x;
+    gl_Position = mvp * vec4(position, spriteDepth(), 1.0);
+}
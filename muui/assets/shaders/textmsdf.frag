@@ -0,0 +1,21 @@
+precision highp float;
+
+#include "sprite.inc.frag"
+
+in vec2 vs_texCoord;
+in vec4 vs_color;
+in float vs_edge;
+out vec4 fragColor;
+
+void main(void)
+{
+    vec3 channels = sampleBaseColor(vs_texCoord).rgb;
+    float distance = max(min(channels.r, channels.g), min(max(channels.r, channels.g), channels.b)); // median
+    // antialias over about one screen pixel, whatever the scale the glyph is drawn at
+    float smoothing = 0.7 * fwidth(distance);
+    float alpha = smoothstep(vs_edge - smoothing, vs_edge + smoothing, distance);
+    vec4 color = vs_color;
+    color.a *= alpha;
+    color.rgb *= color.a; // premultiply alpha
+    fragColor = color;
+}
@@ -1,5 +1,7 @@
 #include "buffer.h"
 
+#include "statecache.h"
+
 #include <utility>
 
 namespace muui::gl
@@ -15,7 +17,10 @@ Buffer::Buffer(Type type, Usage usage)
 Buffer::~Buffer()
 {
     if (m_handle)
+    {
+        stateCache().deleteBuffer(m_handle);
         glDeleteBuffers(1, &m_handle);
+    }
 }
 
 Buffer::Buffer(Buffer &&other)
@@ -42,7 +47,7 @@ void swap(Buffer &lhs, Buffer &rhs)
 
 void Buffer::bind() const
 {
-    glBindBuffer(m_type, m_handle);
+    stateCache().bindBuffer(m_type, m_handle);
 }
 
 void Buffer::allocate(std::size_t size) const
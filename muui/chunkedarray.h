@@ -0,0 +1,77 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace muui
+{
+
+// Growable array that allocates storage in fixed-size chunks. Elements never move once allocated, and clear() keeps
+// the chunks around so the memory can be reused by the next round of insertions.
+template<typename T, std::size_t ChunkSize>
+class ChunkedArray : private NonCopyable
+{
+public:
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_chunks.size() * ChunkSize; }
+    bool empty() const { return m_size == 0; }
+
+    T &operator[](std::size_t index)
+    {
+        assert(index < m_size);
+        return (*m_chunks[index / ChunkSize])[index % ChunkSize];
+    }
+
+    const T &operator[](std::size_t index) const
+    {
+        assert(index < m_size);
+        return (*m_chunks[index / ChunkSize])[index % ChunkSize];
+    }
+
+    // Returns a reference to a new element at the end of the array. The element is NOT reinitialized if its storage
+    // was used before.
+    T &append()
+    {
+        if (m_size == capacity())
+            m_chunks.emplace_back(new Chunk);
+        const auto index = m_size++;
+        return (*m_chunks[index / ChunkSize])[index % ChunkSize];
+    }
+
+    void clear() { m_size = 0; }
+
+    // Releases the chunks that aren't needed to hold `capacity` elements.
+    void shrink(std::size_t capacity)
+    {
+        const auto chunkCount = (std::max(capacity, m_size) + ChunkSize - 1) / ChunkSize;
+        if (chunkCount < m_chunks.size())
+        {
+            m_chunks.resize(chunkCount);
+            m_chunks.shrink_to_fit();
+        }
+    }
+
+    template<typename Visitor>
+    void forEach(Visitor visitor)
+    {
+        for (std::size_t i = 0; i < m_size; i += ChunkSize)
+        {
+            auto &chunk = *m_chunks[i / ChunkSize];
+            const auto count = std::min(ChunkSize, m_size - i);
+            for (std::size_t j = 0; j < count; ++j)
+                visitor(chunk[j]);
+        }
+    }
+
+private:
+    using Chunk = std::array<T, ChunkSize>;
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    std::size_t m_size{0};
+};
+
+} // namespace muui
@@ -3,6 +3,7 @@
 #include "framebuffer.h"
 #include "shadermanager.h"
 #include "spritebatcher.h"
+#include "statecache.h"
 #include "system.h"
 
 namespace muui
@@ -24,9 +25,10 @@ void DropShadow::applyEffect(Painter *painter, int depth)
 {
     auto *shaderManager = sys::shaderManager();
     shaderManager->useProgram(ShaderManager::ProgramHandle::GaussianBlur);
-    shaderManager->setUniform("baseColorTexture", 0);
+    shaderManager->setUniform(ShaderManager::UniformId::BaseColorTexture, 0);
 
-    glDisable(GL_BLEND);
+    auto &stateCache = gl::stateCache();
+    stateCache.setEnabled(GL_BLEND, false);
 
     auto applyBlur = [this, shaderManager](const gl::Texture *source, std::unique_ptr<gl::Framebuffer> &dest,
                                            bool horizontal) {
@@ -34,7 +36,7 @@ void DropShadow::applyEffect(Painter *painter, int depth)
         const auto h = height();
         if (!dest || dest->width() != w || dest->height() != h)
             dest = std::make_unique<gl::Framebuffer>(w, h);
-        shaderManager->setUniform("horizontal", horizontal);
+        shaderManager->setUniform(ShaderManager::UniformId::Horizontal, horizontal);
         source->bind(0);
         {
             gl::FramebufferBinder binder(*dest);
@@ -49,7 +51,7 @@ void DropShadow::applyEffect(Painter *painter, int depth)
         first = false;
     }
 
-    glEnable(GL_BLEND);
+    stateCache.setEnabled(GL_BLEND, true);
 
     auto *spriteBatcher = painter->spriteBatcher();
     auto blitResult = [this, spriteBatcher](const gl::Texture *source, const glm::vec2 &offset, const glm::vec4 &color,
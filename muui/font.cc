@@ -2,9 +2,12 @@
 
 #include "file.h"
 #include "log.h"
-#include "pixmap.h"
+#include "msdf.h"
+#include "system.h"
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include <stb_truetype.h>
 
@@ -20,6 +23,8 @@ struct FontInfo
 namespace
 {
 
+constexpr auto DistanceFieldEdgeValue = 128;
+
 std::unique_ptr<FontInfo> loadFont(const std::filesystem::path &path)
 {
     File file(path);
@@ -63,11 +68,26 @@ FontInfo *FontInfoCache::get(const std::filesystem::path &path)
 
 Font::Font(TextureAtlas *textureAtlas)
     : m_textureAtlas(textureAtlas)
+    , m_denseGlyphs(DenseGlyphCount, NoGlyph)
 {
 }
 
+// the futures of std::async wait for the workers, which use the font
+Font::~Font()
+{
+    m_glyphSourcePreloadConnection.disconnect();
+    // running tasks rasterize with this font, deferred ones never started
+    for (auto &preload : m_preloads)
+    {
+        if (preload.wait_for(std::chrono::seconds(0)) != std::future_status::deferred)
+            preload.wait();
+    }
+}
+
 bool Font::load(const std::filesystem::path &path, int pixelHeight, int outlineSize)
 {
+    assert(!preloading());
+
     static FontInfoCache cache;
 
     m_fontInfo = cache.get(path);
@@ -90,12 +110,186 @@ bool Font::load(const std::filesystem::path &path, int pixelHeight, int outlineS
     return true;
 }
 
-const Font::Glyph *Font::glyph(int codepoint)
+bool Font::loadDistanceField(const std::filesystem::path &path, DistanceField type)
 {
-    auto it = m_glyphs.find(codepoint);
-    if (it == m_glyphs.end())
-        it = m_glyphs.emplace(codepoint, initializeGlyph(codepoint)).first;
-    return it->second.get();
+    assert(type != DistanceField::None);
+    if (!load(path, DistanceFieldPixelHeight))
+        return false;
+    m_distanceField = type;
+    return true;
+}
+
+bool Font::load(Font *distanceField, int pixelHeight, int outlineSize)
+{
+    assert(!preloading());
+    assert(distanceField->isDistanceField() && !distanceField->m_glyphSource);
+
+    if (!distanceField->m_fontInfo)
+        return false;
+
+    m_glyphSource = distanceField;
+    m_glyphSourcePreloadConnection.disconnect();
+    m_glyphSourcePreloadConnection = distanceField->preloadFinishedSignal.connect([this] { preloadFinishedSignal(); });
+    m_distanceField = distanceField->distanceField();
+
+    m_scale = static_cast<float>(pixelHeight) / distanceField->pixelHeight();
+    m_ascent = m_scale * distanceField->ascent();
+    m_descent = m_scale * distanceField->descent();
+    m_lineGap = m_scale * distanceField->lineGap();
+
+    m_pixelHeight = pixelHeight;
+    m_outlineSize = outlineSize;
+
+    return true;
+}
+
+float Font::glyphEdge() const
+{
+    return static_cast<float>(DistanceFieldEdgeValue) / 255.0f;
+}
+
+float Font::outlineEdge() const
+{
+    // the distance field drops to zero at DistanceFieldSpread pixels from the edge, so outlines are clamped to that
+    const auto outlineSize = static_cast<float>(m_outlineSize * DistanceFieldPixelHeight) / m_pixelHeight;
+    return glyphEdge() * std::max(1.0f - outlineSize / DistanceFieldSpread, 0.0f);
+}
+
+const Font::Glyph *Font::loadGlyph(int codepoint)
+{
+    auto &slot = glyphSlot(codepoint);
+    if (slot == NoGlyph)
+    {
+        if (m_glyphSource)
+        {
+            slot = storeGlyph(scaleGlyph(m_glyphSource->glyph(codepoint)));
+        }
+        else
+        {
+            // glyphs still being preloaded are rasterized again rather than waited for, the worker's copy is dropped
+            slot = storeGlyph(initializeGlyph(rasterizeGlyph(codepoint)));
+        }
+    }
+    return glyphAt(slot);
+}
+
+std::optional<Font::Glyph> Font::scaleGlyph(const Glyph *sourceGlyph) const
+{
+    if (!sourceGlyph)
+        return {};
+    const auto &boundingBox = sourceGlyph->boundingBox;
+    return Glyph{.boundingBox = RectF{m_scale * boundingBox.min, m_scale * boundingBox.max},
+                 .advanceWidth = m_scale * sourceGlyph->advanceWidth,
+                 .pixmap = sourceGlyph->pixmap};
+}
+
+std::uint32_t &Font::glyphSlot(int codepoint)
+{
+    if (codepoint >= 0 && codepoint < DenseGlyphCount)
+        return m_denseGlyphs[codepoint];
+    auto &page = m_glyphPages[codepoint >> GlyphPageBits];
+    if (!page)
+    {
+        page = std::make_unique<GlyphPage>();
+        page->fill(NoGlyph);
+    }
+    return (*page)[codepoint & (GlyphPageSize - 1)];
+}
+
+std::uint32_t Font::storeGlyph(std::optional<Glyph> glyph)
+{
+    if (!glyph)
+        return MissingGlyph;
+    if (m_glyphCount % GlyphChunkSize == 0)
+        m_glyphChunks.push_back(std::make_unique<GlyphChunk>());
+    (*m_glyphChunks.back())[m_glyphCount % GlyphChunkSize] = *glyph;
+    return ++m_glyphCount;
+}
+
+void Font::preload(std::u32string_view codepoints)
+{
+    preloadCodepoints(std::vector<int>(codepoints.begin(), codepoints.end()));
+}
+
+void Font::preload(std::span<const CodepointRange> ranges)
+{
+    std::vector<int> codepoints;
+    for (const auto &range : ranges)
+    {
+        for (auto codepoint = range.first; codepoint <= range.last; ++codepoint)
+            codepoints.push_back(codepoint);
+    }
+    preloadCodepoints(std::move(codepoints));
+}
+
+void Font::preloadCodepoints(std::vector<int> codepoints)
+{
+    if (m_glyphSource)
+    {
+        m_glyphSource->preloadCodepoints(std::move(codepoints));
+        return;
+    }
+    if (!m_fontInfo)
+        return;
+    std::erase_if(codepoints, [this](int codepoint) {
+        return glyphSlot(codepoint) != NoGlyph || !m_preloadedGlyphs.insert(codepoint).second;
+    });
+    if (codepoints.empty())
+        return;
+
+#if defined(__EMSCRIPTEN__)
+    // built without thread support, the glyphs are rasterized when they're committed on the next frame
+    constexpr auto LaunchPolicy = std::launch::deferred;
+    sys::requestUpdate();
+#else
+    constexpr auto LaunchPolicy = std::launch::async;
+#endif
+
+    // enough glyphs per task to make up for starting a thread
+    constexpr std::size_t MinGlyphsPerTask = 16;
+    const auto threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    const auto taskCount =
+        std::min<std::size_t>(threadCount, (codepoints.size() + MinGlyphsPerTask - 1) / MinGlyphsPerTask);
+    const auto glyphsPerTask = (codepoints.size() + taskCount - 1) / taskCount;
+    for (std::size_t first = 0; first < codepoints.size(); first += glyphsPerTask)
+    {
+        const auto last = std::min(first + glyphsPerTask, codepoints.size());
+        std::vector<int> taskCodepoints(codepoints.begin() + first, codepoints.begin() + last);
+        m_preloads.push_back(std::async(LaunchPolicy, [this, codepoints = std::move(taskCodepoints)] {
+            std::vector<RasterizedGlyph> glyphs;
+            glyphs.reserve(codepoints.size());
+            for (auto codepoint : codepoints)
+                glyphs.push_back(rasterizeGlyph(codepoint));
+            // the glyphs are committed on the next frame
+            sys::requestUpdate();
+            return glyphs;
+        }));
+    }
+}
+
+void Font::commitPreloadedGlyphs()
+{
+    if (m_glyphSource)
+    {
+        m_glyphSource->commitPreloadedGlyphs();
+        return;
+    }
+    if (m_preloads.empty())
+        return;
+    std::erase_if(m_preloads, [this](auto &preload) {
+        // deferred tasks run here
+        if (preload.wait_for(std::chrono::seconds(0)) == std::future_status::timeout)
+            return false;
+        for (const auto &rasterizedGlyph : preload.get())
+        {
+            m_preloadedGlyphs.erase(rasterizedGlyph.codepoint);
+            if (auto &slot = glyphSlot(rasterizedGlyph.codepoint); slot == NoGlyph)
+                slot = storeGlyph(initializeGlyph(rasterizedGlyph));
+        }
+        return true;
+    });
+    if (m_preloads.empty())
+        preloadFinishedSignal();
 }
 
 float Font::textWidth(std::u32string_view text)
@@ -109,7 +303,7 @@ float Font::textWidth(std::u32string_view text)
     return width;
 }
 
-std::unique_ptr<Font::Glyph> Font::initializeGlyph(int codepoint)
+Font::RasterizedGlyph Font::rasterizeGlyph(int codepoint) const
 {
     int ix0, iy0, ix1, iy1;
     stbtt_GetCodepointBitmapBox(&m_fontInfo->font, codepoint, m_scale, m_scale, &ix0, &iy0, &ix1, &iy1);
@@ -119,8 +313,10 @@ std::unique_ptr<Font::Glyph> Font::initializeGlyph(int codepoint)
 
     constexpr auto Border = 1;
 
-    const int margin = Border + m_outlineSize;
-    const auto pixelType = m_outlineSize == 0 ? PixelType::Grayscale : PixelType::RGBA;
+    const int margin = isDistanceField() ? DistanceFieldSpread : Border + m_outlineSize;
+    const auto pixelType = m_distanceField == DistanceField::MultiChannel ? PixelType::RGB
+                           : m_outlineSize == 0                           ? PixelType::Grayscale
+                                                                          : PixelType::RGBA;
 
     Pixmap pixmap;
     pixmap.width = width + 2 * margin;
@@ -129,7 +325,33 @@ std::unique_ptr<Font::Glyph> Font::initializeGlyph(int codepoint)
     pixmap.pixels.resize(pixmap.width * pixmap.height * pixelSizeInBytes(pixelType));
     std::fill(pixmap.pixels.begin(), pixmap.pixels.end(), 0);
 
-    if (m_outlineSize == 0)
+    if (m_distanceField == DistanceField::MultiChannel)
+    {
+        const auto pixelDistScale = static_cast<float>(DistanceFieldEdgeValue) / margin;
+        auto msdf = codepointMsdf(m_fontInfo->font, m_scale, codepoint, margin, DistanceFieldEdgeValue, pixelDistScale);
+        if (msdf)
+        {
+            assert(msdf.width == pixmap.width);
+            assert(msdf.height == pixmap.height);
+            pixmap = std::move(msdf);
+        }
+    }
+    else if (m_distanceField == DistanceField::SingleChannel)
+    {
+        const auto pixelDistScale = static_cast<float>(DistanceFieldEdgeValue) / margin;
+        int sdfWidth = 0, sdfHeight = 0, xOff = 0, yOff = 0;
+        auto *sdf = stbtt_GetCodepointSDF(&m_fontInfo->font, m_scale, codepoint, margin, DistanceFieldEdgeValue,
+                                          pixelDistScale, &sdfWidth, &sdfHeight, &xOff, &yOff);
+        if (sdf)
+        {
+            assert(sdfWidth == pixmap.width);
+            assert(sdfHeight == pixmap.height);
+            assert(pixmap.pixelType == PixelType::Grayscale);
+            std::copy(sdf, sdf + sdfWidth * sdfHeight, pixmap.pixels.begin());
+            free(sdf);
+        }
+    }
+    else if (m_outlineSize == 0)
     {
         std::vector<unsigned char> pixels;
         pixels.resize(width * height);
@@ -185,13 +407,6 @@ std::unique_ptr<Font::Glyph> Font::initializeGlyph(int codepoint)
         }
     }
 
-    auto packedPixmap = m_textureAtlas->addPixmap(pixmap);
-    if (!packedPixmap)
-    {
-        log_error("Couldn't fit glyph {} in texture atlas", codepoint);
-        return {};
-    }
-
     int advanceWidth, leftSideBearing;
     stbtt_GetCodepointHMetrics(&m_fontInfo->font, codepoint, &advanceWidth, &leftSideBearing);
 
@@ -199,14 +414,28 @@ std::unique_ptr<Font::Glyph> Font::initializeGlyph(int codepoint)
     ix1 += margin;
     iy0 -= margin;
     iy1 += margin;
-    assert(packedPixmap->width == ix1 - ix0);
-    assert(packedPixmap->height == iy1 - iy0);
-
-    auto glyph = std::make_unique<Glyph>();
-    glyph->boundingBox = RectI{{ix0, iy0}, {ix1, iy1}};
-    glyph->advanceWidth = m_scale * advanceWidth;
-    glyph->pixmap = *packedPixmap;
-    return glyph;
+
+    return RasterizedGlyph{.codepoint = codepoint,
+                           .boundingBox = RectI{{ix0, iy0}, {ix1, iy1}},
+                           .advanceWidth = m_scale * advanceWidth,
+                           .pixmap = std::move(pixmap)};
+}
+
+std::optional<Font::Glyph> Font::initializeGlyph(const RasterizedGlyph &rasterizedGlyph)
+{
+    auto packedPixmap = m_textureAtlas->addPixmap(rasterizedGlyph.pixmap);
+    if (!packedPixmap)
+    {
+        log_error("Couldn't fit glyph {} in texture atlas", rasterizedGlyph.codepoint);
+        return {};
+    }
+    assert(packedPixmap->width == rasterizedGlyph.boundingBox.width());
+    assert(packedPixmap->height == rasterizedGlyph.boundingBox.height());
+
+    const auto &boundingBox = rasterizedGlyph.boundingBox;
+    return Glyph{.boundingBox = RectF{glm::vec2(boundingBox.min), glm::vec2(boundingBox.max)},
+                 .advanceWidth = rasterizedGlyph.advanceWidth,
+                 .pixmap = *packedPixmap};
 }
 
 } // namespace muui
@@ -1,49 +1,141 @@
 #pragma once
 
+#include "pixmap.h"
 #include "textureatlas.h"
 #include "util.h"
 
+#include <muslots/muslots.h>
+
+#include <array>
+#include <cstdint>
 #include <filesystem>
+#include <future>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace muui
 {
 class FontInfo;
-struct Pixmap;
 
 class Font
 {
 public:
     explicit Font(TextureAtlas *textureAtlas);
+    ~Font();
 
     bool load(const std::filesystem::path &path, int pixelHeight, int outlineSize = 0);
+    // Distance field fonts rasterize their glyphs once, at DistanceFieldPixelHeight. Fonts loaded from them draw the
+    // same glyphs at any pixel height with the distance field text shaders, so they share their texture atlas space.
+    enum class DistanceField
+    {
+        None,
+        SingleChannel,
+        MultiChannel, // keeps corners sharp when scaled up, in three times the atlas space
+    };
+    bool loadDistanceField(const std::filesystem::path &path, DistanceField type = DistanceField::SingleChannel);
+    bool load(Font *distanceField, int pixelHeight, int outlineSize = 0);
+
+    static constexpr int DistanceFieldPixelHeight = 48;
+    static constexpr int DistanceFieldSpread = 8; // in pixels at DistanceFieldPixelHeight
 
     struct Glyph
     {
-        RectI boundingBox;
+        RectF boundingBox;
         float advanceWidth;
         PackedPixmap pixmap;
     };
-    const Glyph *glyph(int codepoint);
+    const Glyph *glyph(int codepoint)
+    {
+        if (codepoint >= 0 && codepoint < DenseGlyphCount && m_denseGlyphs[codepoint] != NoGlyph)
+            return glyphAt(m_denseGlyphs[codepoint]);
+        return loadGlyph(codepoint);
+    }
+
+    struct CodepointRange
+    {
+        char32_t first;
+        char32_t last; // inclusive
+    };
+    // Rasterizes the glyphs on worker threads, so that the first frame showing them doesn't have to. They're added
+    // to the texture atlas by commitPreloadedGlyphs(), then preloadFinishedSignal is emitted. The font can't be
+    // loaded again meanwhile. Builds without threads (Emscripten) rasterize them in commitPreloadedGlyphs().
+    void preload(std::u32string_view codepoints);
+    void preload(std::span<const CodepointRange> ranges);
+    bool preloading() const { return m_glyphSource ? m_glyphSource->preloading() : !m_preloads.empty(); }
+    // Adds the glyphs rasterized since the last call to the texture atlas, from the render thread
+    void commitPreloadedGlyphs();
+
+    muslots::Signal<> preloadFinishedSignal;
 
     int pixelHeight() const { return m_pixelHeight; }
     int outlineSize() const { return m_outlineSize; }
+    DistanceField distanceField() const { return m_distanceField; }
+    bool isDistanceField() const { return m_distanceField != DistanceField::None; }
+    // values of the distance field on the edges of the glyphs and of their outline
+    float glyphEdge() const;
+    float outlineEdge() const;
     float ascent() const { return m_ascent; }
     float descent() const { return m_descent; }
     float lineGap() const { return m_lineGap; }
     float textWidth(std::u32string_view text);
 
 private:
-    std::unique_ptr<Glyph> initializeGlyph(int codepoint);
+    struct RasterizedGlyph
+    {
+        int codepoint;
+        RectI boundingBox;
+        float advanceWidth;
+        Pixmap pixmap;
+    };
+    // only reads the font, so that it can run on any thread
+    RasterizedGlyph rasterizeGlyph(int codepoint) const;
+    std::optional<Glyph> initializeGlyph(const RasterizedGlyph &rasterizedGlyph);
+    std::optional<Glyph> scaleGlyph(const Glyph *sourceGlyph) const;
+
+    // Glyphs are stored in chunks that never move, and looked up by codepoint in a table with a slot for every
+    // codepoint up to DenseGlyphCount, or in pages of GlyphPageSize slots for the rest. Slots hold the index of the
+    // glyph plus one.
+    static constexpr int DenseGlyphCount = 0x2000;
+    static constexpr int GlyphPageBits = 8;
+    static constexpr int GlyphPageSize = 1 << GlyphPageBits;
+    static constexpr std::uint32_t NoGlyph = 0;
+    static constexpr std::uint32_t MissingGlyph = ~0u; // couldn't be initialized
+    using GlyphPage = std::array<std::uint32_t, GlyphPageSize>;
+    static constexpr int GlyphChunkBits = 6;
+    static constexpr int GlyphChunkSize = 1 << GlyphChunkBits;
+    using GlyphChunk = std::array<Glyph, GlyphChunkSize>;
+
+    const Glyph *glyphAt(std::uint32_t slot) const
+    {
+        if (slot == MissingGlyph)
+            return nullptr;
+        const auto index = slot - 1;
+        return &(*m_glyphChunks[index >> GlyphChunkBits])[index & (GlyphChunkSize - 1)];
+    }
+    const Glyph *loadGlyph(int codepoint);
+    std::uint32_t &glyphSlot(int codepoint);
+    std::uint32_t storeGlyph(std::optional<Glyph> glyph);
+    void preloadCodepoints(std::vector<int> codepoints);
 
     TextureAtlas *m_textureAtlas;
     FontInfo *m_fontInfo{nullptr};
-    std::unordered_map<int, std::unique_ptr<Glyph>> m_glyphs;
+    Font *m_glyphSource{nullptr}; // the distance field font this one scales the glyphs of
+    muslots::Connection m_glyphSourcePreloadConnection;
+    DistanceField m_distanceField{DistanceField::None};
+    std::vector<std::unique_ptr<GlyphChunk>> m_glyphChunks;
+    std::uint32_t m_glyphCount{0};
+    std::vector<std::uint32_t> m_denseGlyphs;
+    std::unordered_map<int, std::unique_ptr<GlyphPage>> m_glyphPages;
+    std::unordered_set<int> m_preloadedGlyphs; // rasterized by workers and not committed yet
+    std::vector<std::future<std::vector<RasterizedGlyph>>> m_preloads;
     int m_pixelHeight{0};
     int m_outlineSize{0};
-    float m_scale{0.0f};
+    float m_scale{0.0f}; // relative to the glyph source, if any
     float m_ascent{0.0f};
     float m_descent{0.0f};
     float m_lineGap{0.0f};
@@ -21,19 +21,30 @@ std::size_t FontCache::FontKeyHasher::operator()(const FontCache::FontKey &key)
     std::size_t hash = 311;
     hash = hash * 31 + static_cast<std::size_t>(key.pixelHeight);
     hash = hash * 31 + static_cast<std::size_t>(key.outlineSize);
+    hash = hash * 31 + static_cast<std::size_t>(key.distanceField);
     hash = hash * 31 + std::hash<std::string>()(key.name);
     return hash;
 }
 
 Font *FontCache::font(std::string_view source, int pixelHeight, int outlineSize)
 {
-    FontKey key{std::string(source), pixelHeight};
+    FontKey key{std::string(source), pixelHeight, outlineSize, m_distanceField};
     auto it = m_fonts.find(key);
     if (it == m_fonts.end())
     {
         auto font = std::make_unique<Font>(m_textureAtlas);
-        const auto path = m_rootPath / fmt::format("{}.ttf", source);
-        if (!font->load(path, pixelHeight, outlineSize))
+        bool loaded = false;
+        if (m_distanceField != Font::DistanceField::None)
+        {
+            auto *distanceField = distanceFieldFont(source);
+            loaded = distanceField && font->load(distanceField, pixelHeight, outlineSize);
+        }
+        else
+        {
+            const auto path = m_rootPath / fmt::format("{}.ttf", source);
+            loaded = font->load(path, pixelHeight, outlineSize);
+        }
+        if (!loaded)
         {
             log_error("Failed to load font {}", source);
             font.reset();
@@ -43,6 +54,35 @@ Font *FontCache::font(std::string_view source, int pixelHeight, int outlineSize)
     return it->second.get();
 }
 
+Font *FontCache::distanceFieldFont(std::string_view source)
+{
+    FontKey key{std::string(source), Font::DistanceFieldPixelHeight, 0, m_distanceField};
+    auto it = m_distanceFieldFonts.find(key);
+    if (it == m_distanceFieldFonts.end())
+    {
+        auto font = std::make_unique<Font>(m_textureAtlas);
+        const auto path = m_rootPath / fmt::format("{}.ttf", source);
+        if (!font->loadDistanceField(path, m_distanceField))
+            font.reset();
+        it = m_distanceFieldFonts.emplace(std::move(key), std::move(font)).first;
+    }
+    return it->second.get();
+}
+
+void FontCache::setDistanceField(Font::DistanceField distanceField)
+{
+    m_distanceField = distanceField;
+}
+
+void FontCache::commitPreloadedGlyphs()
+{
+    for (auto &[key, font] : m_fonts)
+    {
+        if (font)
+            font->commitPreloadedGlyphs();
+    }
+}
+
 void FontCache::setRootPath(const std::filesystem::path &path)
 {
     m_rootPath = path;
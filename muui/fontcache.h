@@ -23,6 +23,12 @@ public:
     ~FontCache();
 
     Font *font(std::string_view name, int pixelHeight, int outlineSize = 0);
+    // Unless it's None, fonts returned from then on share the glyphs of one distance field font per name, whatever
+    // their pixel height
+    void setDistanceField(Font::DistanceField distanceField);
+    Font::DistanceField distanceField() const { return m_distanceField; }
+    // see Font::preload()
+    void commitPreloadedGlyphs();
 
     void setRootPath(const std::filesystem::path &path);
     const std::filesystem::path &rootPath() const { return m_rootPath; }
@@ -34,13 +40,19 @@ private:
         std::string name;
         int pixelHeight;
         int outlineSize;
+        Font::DistanceField distanceField;
         bool operator==(const FontKey &other) const = default;
     };
     struct FontKeyHasher
     {
         std::size_t operator()(const FontKey &key) const;
     };
+    Font *distanceFieldFont(std::string_view name);
+
+    // destroyed after the fonts using their glyphs
+    std::unordered_map<FontKey, std::unique_ptr<Font>, FontKeyHasher> m_distanceFieldFonts;
     std::unordered_map<FontKey, std::unique_ptr<Font>, FontKeyHasher> m_fonts;
+    Font::DistanceField m_distanceField{Font::DistanceField::None};
     std::filesystem::path m_rootPath;
 };
 
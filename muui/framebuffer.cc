@@ -1,6 +1,7 @@
 #include "framebuffer.h"
 
 #include "log.h"
+#include "statecache.h"
 
 namespace muui::gl
 {
@@ -18,12 +19,13 @@ Framebuffer::Framebuffer(int width, int height)
 
     FramebufferBinder binder(*this);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture.id(), 0);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_rboId);
 }
 
 Framebuffer::~Framebuffer()
 {
+    stateCache().deleteFramebuffer(m_fboId, m_rboId);
     if (m_fboId)
         glDeleteFramebuffers(1, &m_fboId);
     if (m_rboId)
@@ -51,26 +53,66 @@ Framebuffer &Framebuffer::operator=(Framebuffer &&other)
     return *this;
 }
 
+void Framebuffer::blit() const
+{
+    GLuint drawFboId = 0;
+    if (const auto cached = stateCache().framebuffer())
+    {
+        drawFboId = *cached;
+    }
+    else
+    {
+        GLint id = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &id);
+        drawFboId = static_cast<GLuint>(id);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fboId);
+    glBlitFramebuffer(0, 0, width(), height(), 0, 0, width(), height(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, drawFboId);
+}
+
 void Framebuffer::bind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fboId);
-    glBindRenderbuffer(GL_RENDERBUFFER, m_rboId);
+    auto &cache = stateCache();
+    cache.bindFramebuffer(m_fboId);
+    cache.bindRenderbuffer(m_rboId);
 }
 
 FramebufferBinder::FramebufferBinder(const Framebuffer &framebuffer)
 {
-    glGetIntegerv(GL_VIEWPORT, m_prevViewport.data());
-    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_prevFboId);
-    glGetIntegerv(GL_RENDERBUFFER_BINDING, &m_prevRboId);
+    // only query the state the cache doesn't know about yet
+    auto &cache = stateCache();
+    if (const auto viewport = cache.viewport())
+    {
+        m_prevViewport = *viewport;
+    }
+    else
+    {
+        glGetIntegerv(GL_VIEWPORT, m_prevViewport.data());
+    }
+    const auto queryBinding = [](std::optional<GLuint> cached, GLenum binding) {
+        if (cached)
+            return *cached;
+        GLint id = 0;
+        glGetIntegerv(binding, &id);
+        return static_cast<GLuint>(id);
+    };
+    m_prevFboId = queryBinding(cache.framebuffer(), GL_FRAMEBUFFER_BINDING);
+    m_prevRboId = queryBinding(cache.renderbuffer(), GL_RENDERBUFFER_BINDING);
+    // the scissor is set up for the window, see Screen::setPartialUpdatesEnabled()
+    m_prevScissorTest = cache.isEnabled(GL_SCISSOR_TEST);
+    cache.setEnabled(GL_SCISSOR_TEST, false);
     framebuffer.bind();
-    glViewport(0, 0, framebuffer.width(), framebuffer.height());
+    cache.setViewport({0, 0, framebuffer.width(), framebuffer.height()});
 }
 
 FramebufferBinder::~FramebufferBinder()
 {
-    glBindRenderbuffer(GL_RENDERBUFFER, m_prevRboId);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_prevFboId);
-    glViewport(m_prevViewport[0], m_prevViewport[1], m_prevViewport[2], m_prevViewport[3]);
+    auto &cache = stateCache();
+    cache.bindRenderbuffer(m_prevRboId);
+    cache.bindFramebuffer(m_prevFboId);
+    cache.setViewport(m_prevViewport);
+    cache.setEnabled(GL_SCISSOR_TEST, m_prevScissorTest);
 }
 
 } // namespace muui::gl
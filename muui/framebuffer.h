@@ -24,6 +24,9 @@ public:
     int height() const { return m_texture.height(); }
     const Texture *texture() const { return &m_texture; }
 
+    // Copies the color buffer to the framebuffer currently bound
+    void blit() const;
+
 private:
     void bind() const;
 
@@ -47,9 +50,10 @@ public:
     FramebufferBinder &operator=(const FramebufferBinder &&) = delete;
 
 private:
-    GLint m_prevFboId{0};
-    GLint m_prevRboId{0};
+    GLuint m_prevFboId{0};
+    GLuint m_prevRboId{0};
     std::array<GLint, 4> m_prevViewport;
+    bool m_prevScissorTest{false};
 };
 
 } // namespace muui::gl
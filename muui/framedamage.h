@@ -0,0 +1,27 @@
+#pragma once
+
+#include "util.h"
+
+#include <optional>
+
+namespace muui
+{
+
+// Window area changed by the current frame. Screens with partial updates add what they redrew to sys::frameDamage(),
+// the others damage the whole window. Application resets it at the start of each frame.
+struct FrameDamage
+{
+    bool tracked{false}; // if unset nobody reported damage, so the whole window is assumed to have changed
+    bool full{false};
+    std::optional<RectF> rect;
+
+    void add(const std::optional<RectF> &damage)
+    {
+        tracked = true;
+        if (damage)
+            rect = rect ? *rect | *damage : *damage;
+    }
+    void addFull() { full = true; }
+};
+
+} // namespace muui
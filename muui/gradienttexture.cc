@@ -17,13 +17,18 @@ GradientTexture::GradientTexture()
 }
 
 void GradientTexture::bind(int textureUnit) const
+{
+    upload();
+    m_texture.bind(textureUnit);
+}
+
+void GradientTexture::upload() const
 {
     if (m_dirty)
     {
         updateTextureData();
         m_dirty = false;
     }
-    m_texture.bind(textureUnit);
 }
 
 void GradientTexture::setColorAt(float position, const glm::vec4 &color)
@@ -22,6 +22,7 @@ public:
     GradientTexture();
 
     void bind(int textureUnit = 0) const override;
+    void upload() const override;
 
     void setColorAt(float position, const glm::vec4 &color);
     void setStops(const std::vector<GradientStop> &stops);
@@ -3,13 +3,17 @@
 #include "fontcache.h"
 #include "painter.h"
 #include "pixmapcache.h"
+#include "renderlist.h"
 #include "shadereffect.h"
 #include "system.h"
 
 #include <glm/gtx/matrix_transform_2d.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <memory>
+#include <span>
 
 namespace muui
 {
@@ -24,9 +28,10 @@ Font *defaultFont()
 Item::LayoutItem::LayoutItem(std::unique_ptr<Item> item, Item *parent)
     : m_item(std::move(item))
     , m_resizedConnection{m_item->resizedSignal.connect([parent](Size) { parent->handleChildUpdated(); })}
-    , m_anchorChangedConnection{m_item->anchorChangedSignal.connect([parent] { parent->updateLayout(); })}
-    , m_alignmentChangedConnection{m_item->alignmentChangedSignal.connect([parent] { parent->updateLayout(); })}
+    , m_anchorChangedConnection{m_item->anchorChangedSignal.connect([parent] { parent->invalidateLayout(); })}
+    , m_alignmentChangedConnection{m_item->alignmentChangedSignal.connect([parent] { parent->invalidateLayout(); })}
 {
+    m_item->m_parent = parent;
 }
 
 Item::LayoutItem::~LayoutItem()
@@ -36,8 +41,105 @@ Item::LayoutItem::~LayoutItem()
     m_alignmentChangedConnection.disconnect();
 }
 
+// What the item drew the last time it was rendered in retained mode, and the painter state it depended on
+struct Item::RenderCache
+{
+    struct Key
+    {
+        Transform transform;
+        std::optional<RectF> clipRect;
+        int depth;
+        std::optional<Brush> backgroundBrush;
+        std::optional<Brush> foregroundBrush;
+        std::optional<Brush> outlineBrush;
+
+        bool operator==(const Key &other) const = default;
+    };
+    std::optional<Key> key;
+    RenderList renderList;
+};
+
 Item::Item() = default;
-Item::~Item() = default;
+
+Item::~Item()
+{
+    if (m_nameRegistry)
+        m_nameRegistry->remove(this);
+    if (m_adopted && m_parent)
+        std::erase(m_parent->m_adoptedChildren, this);
+}
+
+void Item::invalidate()
+{
+    // cached ancestors include what this item draws
+    sys::requestUpdate();
+    m_damaged = true;
+    for (auto *item = this; item; item = item->m_parent)
+    {
+        item->m_invalidated = true;
+        if (item->m_parent)
+        {
+            // adopted children are drawn by their parent, which takes the damage for them
+            if (item->m_adopted)
+                item->m_parent->m_damaged = true;
+            item->m_parent->m_childDamaged = true;
+        }
+    }
+}
+
+void Item::updateBounds(const Transform &parentTransform, std::optional<RectF> &damage)
+{
+    if (!m_damaged && !m_childDamaged && m_boundsTransform == parentTransform)
+        return;
+
+    const auto oldBounds = m_bounds;
+    const bool damaged = m_damaged || m_boundsTransform != parentTransform;
+    m_damaged = m_childDamaged = false;
+    m_boundsTransform = parentTransform;
+
+    if (!m_visible)
+    {
+        m_bounds.reset();
+    }
+    else
+    {
+        auto transform = parentTransform;
+        transform.translate(m_transformOrigin);
+        transform.rotate(m_rotation);
+        transform.translate(-m_transformOrigin);
+
+        // effects draw their padding around the item too
+        const auto padding = m_effect ? static_cast<float>(m_effect->padding()) : 0.0f;
+        const std::array corners = {transform.map({-padding, -padding}),
+                                    transform.map({m_size.width + padding, -padding}),
+                                    transform.map({m_size.width + padding, m_size.height + padding}),
+                                    transform.map({-padding, m_size.height + padding})};
+        RectF bounds{corners[0], corners[0]};
+        for (const auto &corner : corners)
+            bounds |= RectF{corner, corner};
+
+        for (auto &layoutItem : m_layoutItems)
+        {
+            auto childTransform = transform;
+            childTransform.translate(layoutItem.offset);
+            auto *item = layoutItem.item();
+            item->updateBounds(childTransform, damage);
+            if (item->m_bounds)
+                bounds |= *item->m_bounds;
+        }
+        m_bounds = bounds;
+    }
+
+    if (damaged)
+    {
+        // what was drawn before and what will be drawn now
+        for (const auto &bounds : {oldBounds, m_bounds})
+        {
+            if (bounds)
+                damage = damage ? *damage | *bounds : *bounds;
+        }
+    }
+}
 
 void Item::update(float elapsed)
 {
@@ -59,6 +161,9 @@ std::unique_ptr<Item> Item::takeChildAt(std::size_t index)
         return {};
     auto it = std::next(m_layoutItems.begin(), index);
     auto item = it->takeItem();
+    item->m_parent = nullptr;
+    if (m_nameRegistry)
+        item->setNameRegistry(nullptr);
     m_layoutItems.erase(it);
     handleChildUpdated();
     return item;
@@ -73,6 +178,7 @@ RectF Item::childRect(std::size_t index)
 {
     if (index >= m_layoutItems.size())
         return {};
+    ensureLayout();
     const auto &layoutItem = m_layoutItems[index];
     const auto &size = layoutItem.item()->m_size;
     return RectF{layoutItem.offset, layoutItem.offset + glm::vec2{size.width, size.height}};
@@ -81,18 +187,93 @@ RectF Item::childRect(std::size_t index)
 std::vector<Item *> Item::children() const
 {
     std::vector<Item *> children;
-    children.reserve(m_layoutItems.size());
-    std::transform(m_layoutItems.begin(), m_layoutItems.end(), std::back_inserter(children),
-                   [](auto &layoutItem) { return layoutItem.item(); });
+    children.reserve(m_layoutItems.size() + m_adoptedChildren.size());
+    forEachChild([&children](Item *child) { children.push_back(child); });
     return children;
 }
 
+void Item::adoptChild(Item *child)
+{
+    child->m_parent = this;
+    child->m_adopted = true;
+    m_adoptedChildren.push_back(child);
+    if (m_nameRegistry)
+        child->setNameRegistry(m_nameRegistry);
+}
+
+void Item::setNameRegistry(NameRegistry *registry)
+{
+    if (registry == m_nameRegistry)
+        return;
+    if (m_nameRegistry)
+        m_nameRegistry->remove(this);
+    m_nameRegistry = registry;
+    if (m_nameRegistry)
+        m_nameRegistry->add(this);
+    forEachChild([registry](Item *child) { child->setNameRegistry(registry); });
+}
+
+void Item::setObjectName(std::string_view name)
+{
+    if (name == m_objectName)
+        return;
+    if (m_nameRegistry)
+        m_nameRegistry->remove(this);
+    m_objectName = name;
+    if (m_nameRegistry)
+        m_nameRegistry->add(this);
+}
+
+bool Item::isInSubtree(const Item *item) const
+{
+    for (; item; item = item->m_parent)
+    {
+        if (item == this)
+            return true;
+    }
+    return false;
+}
+
+// Whether the item comes before `item` in the order findChild() walks the tree in
+bool Item::precedes(const Item *item) const
+{
+    std::vector<const Item *> path;
+    for (const auto *ancestor = this; ancestor; ancestor = ancestor->m_parent)
+        path.push_back(ancestor);
+    std::vector<const Item *> otherPath;
+    for (const auto *ancestor = item; ancestor; ancestor = ancestor->m_parent)
+        otherPath.push_back(ancestor);
+
+    // from the root down to the first items that differ
+    auto it = path.rbegin();
+    auto otherIt = otherPath.rbegin();
+    while (it != path.rend() && otherIt != otherPath.rend() && *it == *otherIt)
+    {
+        ++it;
+        ++otherIt;
+    }
+    if (it == path.rbegin())
+        return false; // different trees
+    if (it == path.rend())
+        return otherIt != otherPath.rend(); // an ancestor comes first
+    if (otherIt == otherPath.rend())
+        return false;
+
+    // siblings
+    const Item *first = nullptr;
+    (*it)->m_parent->forEachChild([&first, sibling = *it, otherSibling = *otherIt](const Item *child) {
+        if (!first && (child == sibling || child == otherSibling))
+            first = child;
+    });
+    return first == *it;
+}
+
 bool Item::renderBackground(Painter *painter, int depth)
 {
-    if (!fillBackground)
+    if (!m_fillBackground)
         return false;
     const auto rect = RectF{glm::vec2{0}, glm::vec2(width(), height())};
-    switch (shape)
+    switch (m_shape)
     {
     case Shape::Rectangle:
         painter->drawRect(rect, depth);
@@ -104,7 +285,7 @@ bool Item::renderBackground(Painter *painter, int depth)
         painter->drawCircle(rect.center(), 0.5f * std::max(rect.width(), rect.height()), depth);
         return true;
     case Shape::RoundedRectangle:
-        painter->drawRoundedRect(rect, cornerRadius, depth);
+        painter->drawRoundedRect(rect, m_cornerRadius, depth);
         return true;
     default:
         return false;
@@ -121,7 +302,7 @@ void Item::setSize(Size size)
     if (size == m_size)
         return;
     m_size = size;
-    updateLayout();
+    invalidateLayout();
     resizedSignal(m_size);
 }
 
@@ -130,13 +311,167 @@ void Item::setMargins(Margins margins)
     if (margins == m_margins)
         return;
     m_margins = margins;
-    updateLayout();
+    invalidateLayout();
     marginsChangedSignal(m_margins);
 }
 
 void Item::handleChildUpdated()
 {
-    updateLayout();
+    invalidateLayout();
+}
+
+void Item::invalidateSize()
+{
+    m_sizeInvalidated = true;
+    invalidateLayout();
+}
+
+void Item::invalidateLayout()
+{
+    invalidate();
+    m_layoutInvalidated = true;
+    setLayoutPending();
+}
+
+void Item::setLayoutPending()
+{
+    for (auto *item = this; item && !item->m_layoutPending; item = item->m_parent)
+        item->m_layoutPending = true;
+}
+
+void Item::layout()
+{
+    if (!m_layoutPending)
+        return;
+    // the flags stay set while the children are done, resizing them invalidates this item again
+    for (auto &layoutItem : m_layoutItems)
+        layoutItem.item()->layout();
+    if (m_sizeInvalidated)
+    {
+        m_sizeInvalidated = false;
+        updateSize();
+    }
+    if (m_layoutInvalidated)
+    {
+        m_layoutInvalidated = false;
+        updateLayout();
+        m_boundsInvalidated = true;
+    }
+    if (m_boundsInvalidated)
+    {
+        m_boundsInvalidated = false;
+        if (updateSubtreeBounds())
+            invalidateParentBounds();
+    }
+    m_layoutPending = false;
+}
+
+bool Item::updateSubtreeBounds()
+{
+    // effects draw their padding around the item too
+    const auto padding = m_effect ? static_cast<float>(m_effect->padding()) : 0.0f;
+    auto bounds = RectF{glm::vec2{-padding}, glm::vec2{m_size.width + padding, m_size.height + padding}};
+    for (auto &layoutItem : m_layoutItems)
+    {
+        layoutItem.bounds = layoutItem.item()->transformedSubtreeBounds() + layoutItem.offset;
+        bounds |= layoutItem.bounds;
+    }
+    m_hitGrid.reset();
+    handleChildBoundsUpdated();
+    if (bounds == m_subtreeBounds)
+        return false;
+    m_subtreeBounds = bounds;
+    return true;
+}
+
+RectF Item::transformedSubtreeBounds() const
+{
+    if (m_rotation == 0.0f)
+        return m_subtreeBounds;
+    Transform transform;
+    transform.translate(m_transformOrigin);
+    transform.rotate(m_rotation);
+    transform.translate(-m_transformOrigin);
+    const auto &bounds = m_subtreeBounds;
+    const std::array corners = {transform.map(bounds.min), transform.map({bounds.max.x, bounds.min.y}),
+                                transform.map(bounds.max), transform.map({bounds.min.x, bounds.max.y})};
+    RectF result{corners[0], corners[0]};
+    for (const auto &corner : corners)
+        result |= RectF{corner, corner};
+    return result;
+}
+
+// Buckets the children by the cells of a uniform grid that their bounds overlap, so that a hit test only looks at the
+// children in the cell under the touch position.
+struct Item::HitGrid
+{
+    explicit HitGrid(const std::vector<LayoutItem> &layoutItems);
+
+    std::span<const std::uint32_t> candidates(const glm::vec2 &pos) const;
+
+    RectF area;
+    glm::ivec2 cellCount;
+    glm::vec2 cellSize;
+    std::vector<std::uint32_t> cellStart; // children of cell i are children[cellStart[i]..cellStart[i + 1]]
+    std::vector<std::uint32_t> children;  // in the order they're drawn
+};
+
+Item::HitGrid::HitGrid(const std::vector<LayoutItem> &layoutItems)
+{
+    assert(!layoutItems.empty());
+
+    area = layoutItems.front().bounds;
+    glm::vec2 averageSize{0.0f};
+    for (const auto &layoutItem : layoutItems)
+    {
+        area |= layoutItem.bounds;
+        averageSize += glm::vec2{layoutItem.bounds.width(), layoutItem.bounds.height()};
+    }
+    averageSize /= static_cast<float>(layoutItems.size());
+
+    // cells about the size of a child, but not many more cells than children
+    const auto areaSize = glm::max(glm::vec2{area.width(), area.height()}, glm::vec2{1.0f});
+    auto cells = glm::max(areaSize / glm::max(averageSize, glm::vec2{1.0f}), glm::vec2{1.0f});
+    const auto maxCellCount = 4.0f * static_cast<float>(layoutItems.size());
+    if (cells.x * cells.y > maxCellCount)
+        cells = glm::max(cells * std::sqrt(maxCellCount / (cells.x * cells.y)), glm::vec2{1.0f});
+    cellCount = glm::ivec2{glm::ceil(cells)};
+    cellSize = areaSize / glm::vec2{cellCount};
+
+    const auto cellRange = [this](const RectF &rect) {
+        const auto toCell = [this](const glm::vec2 &p) {
+            return glm::clamp(glm::ivec2{(p - area.min) / cellSize}, glm::ivec2{0}, cellCount - 1);
+        };
+        return std::pair{toCell(rect.min), toCell(rect.max)};
+    };
+    const auto forEachCell = [this, &layoutItems, &cellRange](auto visitor) {
+        for (std::size_t i = 0; i < layoutItems.size(); ++i)
+        {
+            const auto [from, to] = cellRange(layoutItems[i].bounds);
+            for (int y = from.y; y <= to.y; ++y)
+            {
+                for (int x = from.x; x <= to.x; ++x)
+                    visitor(y * cellCount.x + x, static_cast<std::uint32_t>(i));
+            }
+        }
+    };
+
+    cellStart.assign(cellCount.x * cellCount.y + 1, 0);
+    forEachCell([this](int cell, std::uint32_t) { ++cellStart[cell + 1]; });
+    for (std::size_t i = 1; i < cellStart.size(); ++i)
+        cellStart[i] += cellStart[i - 1];
+    children.resize(cellStart.back());
+    auto next = cellStart;
+    forEachCell([this, &next](int cell, std::uint32_t child) { children[next[cell]++] = child; });
+}
+
+std::span<const std::uint32_t> Item::HitGrid::candidates(const glm::vec2 &pos) const
+{
+    if (!area.contains(pos))
+        return {};
+    const auto cell = glm::min(glm::ivec2{(pos - area.min) / cellSize}, cellCount - 1);
+    const auto index = cell.y * cellCount.x + cell.x;
+    return {children.data() + cellStart[index], cellStart[index + 1] - cellStart[index]};
 }
 
 namespace
@@ -223,14 +558,40 @@ void Item::updateLayout()
 
 void Item::render(Painter *painter, int depth)
 {
-    if (!visible)
+    if (!m_visible)
+        return;
+    ensureLayout();
+    // Items recorded in retained mode can't be skipped, the render lists of their ancestors would miss them. They're
+    // cheap to replay, and the scissor discards what they draw outside of the damage.
+    if (const auto damage = painter->damageRect();
+        damage && m_bounds && !painter->retainedRendering() && !damage->intersects(*m_bounds))
+        return;
+    if (const auto clipRect = painter->clipRect(); clipRect && !clipRect->intersects(transformedSubtreeBounds()))
+        return;
+    if (!painter->retainedRendering())
+    {
+        renderItem(painter, depth);
         return;
-    if (const auto clipRect = painter->clipRect())
+    }
+
+    if (!m_renderCache)
+        m_renderCache = std::make_unique<RenderCache>();
+    RenderCache::Key key{painter->transform(),         painter->clipRect(),         depth,
+                         painter->backgroundBrush(), painter->foregroundBrush(), painter->outlineBrush()};
+    if (!m_invalidated && m_renderCache->key == key)
     {
-        const auto rect = RectF{glm::vec2{0}, glm::vec2(width(), height())};
-        if (!clipRect->intersects(rect))
-            return;
+        painter->replay(m_renderCache->renderList);
+        return;
     }
+    m_renderCache->key = std::move(key);
+    painter->beginRecording(&m_renderCache->renderList);
+    renderItem(painter, depth);
+    painter->endRecording();
+    m_invalidated = false;
+}
+
+void Item::renderItem(Painter *painter, int depth)
+{
     if (!m_effect)
     {
         doRender(painter, depth);
@@ -249,18 +610,25 @@ void Item::doRender(Painter *painter, int depth)
     painter->translate(-m_transformOrigin);
 
     PainterBrushSaver brushSaver(painter);
-    if (backgroundBrush)
-        painter->setBackgroundBrush(adjustBrushToRect(*backgroundBrush, painter->transform()));
-    if (foregroundBrush)
-        painter->setForegroundBrush(adjustBrushToRect(*foregroundBrush, painter->transform()));
-    if (outlineBrush)
-        painter->setOutlineBrush(adjustBrushToRect(*outlineBrush, painter->transform()));
+    if (m_backgroundBrush)
+        painter->setBackgroundBrush(adjustBrushToRect(*m_backgroundBrush, painter->transform()));
+    if (m_foregroundBrush)
+        painter->setForegroundBrush(adjustBrushToRect(*m_foregroundBrush, painter->transform()));
+    if (m_outlineBrush)
+        painter->setOutlineBrush(adjustBrushToRect(*m_outlineBrush, painter->transform()));
     if (renderBackground(painter, depth))
         ++depth;
     if (renderContents(painter, depth))
         ++depth;
-    for (auto &layoutItem : m_layoutItems)
+    // cull the children here, before paying for a transform push for each one of them
+    const auto clipRect = painter->clipRect();
+    const auto [first, last] =
+        clipRect ? visibleChildRange(*clipRect) : std::pair<std::size_t, std::size_t>{0, m_layoutItems.size()};
+    for (auto i = first; i < last; ++i)
     {
+        const auto &layoutItem = m_layoutItems[i];
+        if (clipRect && !clipRect->intersects(layoutItem.bounds))
+            continue;
         painter->pushTransform();
         painter->translate(layoutItem.offset);
         layoutItem.item()->render(painter, depth);
@@ -272,16 +640,19 @@ void Item::doRender(Painter *painter, int depth)
 
 Item *Item::mouseEvent(const TouchEvent &event)
 {
-    if (!visible)
+    if (!m_visible)
         return nullptr;
-
-    const auto t0 = glm::translate(glm::mat3(1), -m_transformOrigin);
-    const auto r = glm::rotate(glm::mat3(1), -m_rotation);
-    const auto t1 = glm::translate(glm::mat3(1), m_transformOrigin);
-    const auto m = t1 * r * t0;
+    ensureLayout();
 
     TouchEvent transformedEvent = event;
-    transformedEvent.position = glm::vec2(m * glm::vec3(event.position, 1.0));
+    if (m_rotation != 0.0f)
+    {
+        const auto t0 = glm::translate(glm::mat3(1), -m_transformOrigin);
+        const auto r = glm::rotate(glm::mat3(1), -m_rotation);
+        const auto t1 = glm::translate(glm::mat3(1), m_transformOrigin);
+        const auto m = t1 * r * t0;
+        transformedEvent.position = glm::vec2(m * glm::vec3(event.position, 1.0));
+    }
 
     switch (transformedEvent.type)
     {
@@ -289,15 +660,33 @@ Item *Item::mouseEvent(const TouchEvent &event)
     case TouchEvent::Type::Release:
     case TouchEvent::Type::DragBegin: {
         const auto &pos = transformedEvent.position;
+        // handlers only accept positions inside of their rect, so children whose bounds don't contain it are skipped
+        const auto childHandler = [&transformedEvent, &pos](const LayoutItem &layoutItem) -> Item * {
+            if (!layoutItem.bounds.contains(pos))
+                return nullptr;
+            TouchEvent childEvent = transformedEvent;
+            childEvent.position -= layoutItem.offset;
+            return layoutItem.item()->mouseEvent(childEvent);
+        };
         // back to front, we want items that are drawn last to be tested first
-        for (auto it = m_layoutItems.rbegin(); it != m_layoutItems.rend(); ++it)
+        if (m_layoutItems.size() >= HitGridMinChildren)
         {
-            auto *item = it->item();
-            const auto &offset = it->offset;
-            TouchEvent childEvent = transformedEvent;
-            childEvent.position -= offset;
-            if (auto *handler = item->mouseEvent(childEvent); handler)
-                return handler;
+            if (!m_hitGrid)
+                m_hitGrid = std::make_unique<HitGrid>(m_layoutItems);
+            const auto candidates = m_hitGrid->candidates(pos);
+            for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
+            {
+                if (auto *handler = childHandler(m_layoutItems[*it]); handler)
+                    return handler;
+            }
+        }
+        else
+        {
+            for (auto it = m_layoutItems.rbegin(); it != m_layoutItems.rend(); ++it)
+            {
+                if (auto *handler = childHandler(*it); handler)
+                    return handler;
+            }
         }
         break;
     }
@@ -312,14 +701,78 @@ Item *Item::handleMouseEvent(const TouchEvent &)
     return nullptr;
 }
 
+std::pair<std::size_t, std::size_t> Item::visibleChildRange(const RectF &) const
+{
+    return {0, m_layoutItems.size()};
+}
+
+void Item::setVisible(bool visible)
+{
+    m_visible = visible;
+    invalidate();
+}
+
+void Item::setShape(Shape shape)
+{
+    m_shape = shape;
+    invalidate();
+}
+
+void Item::setFillBackground(bool fillBackground)
+{
+    m_fillBackground = fillBackground;
+    invalidate();
+}
+
+void Item::setBackgroundBrush(const std::optional<Brush> &brush)
+{
+    m_backgroundBrush = brush;
+    invalidate();
+}
+
+void Item::setForegroundBrush(const std::optional<Brush> &brush)
+{
+    m_foregroundBrush = brush;
+    invalidate();
+}
+
+void Item::setOutlineBrush(const std::optional<Brush> &brush)
+{
+    m_outlineBrush = brush;
+    invalidate();
+}
+
+void Item::setCornerRadius(float radius)
+{
+    m_cornerRadius = radius;
+    invalidate();
+}
+
 void Item::setRotation(float angle)
 {
     m_rotation = angle;
+    invalidate();
+    invalidateParentBounds();
 }
 
 void Item::setTransformOrigin(const glm::vec2 &transformOrigin)
 {
     m_transformOrigin = transformOrigin;
+    invalidate();
+    invalidateParentBounds();
+}
+
+void Item::invalidateSubtreeBounds()
+{
+    m_boundsInvalidated = true;
+    setLayoutPending();
+}
+
+void Item::invalidateParentBounds()
+{
+    // the bounds of the parent include the transformed bounds of this item
+    if (m_parent)
+        m_parent->invalidateSubtreeBounds();
 }
 
 void Item::setContainerAlignment(AlignmentFlags alignment)
@@ -380,6 +833,8 @@ void Item::setShaderEffect(std::unique_ptr<ShaderEffect> effect)
 {
     m_effect = std::move(effect);
     m_effect->setSource(this);
+    invalidate();
+    invalidateSubtreeBounds();
 }
 
 ShaderEffect *Item::shaderEffect() const
@@ -390,6 +845,8 @@ ShaderEffect *Item::shaderEffect() const
 void Item::clearShaderEffect()
 {
     m_effect.reset();
+    invalidate();
+    invalidateSubtreeBounds();
 }
 
 Rectangle::Rectangle()
@@ -492,6 +949,7 @@ void Label::setAlignment(AlignmentFlags alignment)
 
 void Label::updateSizeAndOffset()
 {
+    invalidate();
     m_contentHeight = m_font->pixelHeight();
     m_contentWidth = m_font->textWidth(m_text);
     const float height = [this] {
@@ -540,6 +998,10 @@ void Label::updateSizeAndOffset()
         }
     }();
     m_offset = glm::vec2(m_margins.left, m_margins.top) + glm::vec2(xOffset, yOffset);
+
+    m_textLayout.setFont(m_font);
+    m_textLayout.clear();
+    m_textLayout.addText(m_text, {});
 }
 
 bool Label::renderContents(Painter *painter, int depth)
@@ -562,8 +1024,7 @@ bool Label::renderContents(Painter *painter, int depth)
         painter->setClipRect(prevClipRect ? prevClipRect->intersected(rect) : rect);
     }
 
-    painter->setFont(m_font);
-    painter->drawText(m_text, m_offset, depth);
+    painter->drawTextLayout(m_textLayout, m_offset, depth);
 
     if (clipped)
         painter->setClipRect(prevClipRect);
@@ -622,6 +1083,7 @@ void Image::setAlignment(AlignmentFlags alignment)
 
 void Image::updateSizeAndOffset()
 {
+    invalidate();
     const float height = [this] {
         if (m_fixedHeight > 0)
             return m_fixedHeight;
@@ -706,7 +1168,7 @@ bool Image::renderContents(Painter *painter, int depth)
 
 Container::Container()
 {
-    marginsChangedSignal.connect([this](Margins) { updateSize(); });
+    marginsChangedSignal.connect([this](Margins) { invalidateSize(); });
 }
 
 void Container::setSpacing(float spacing)
@@ -714,13 +1176,44 @@ void Container::setSpacing(float spacing)
     if (spacing == m_spacing)
         return;
     m_spacing = spacing;
-    updateSize();
+    invalidateSize();
 }
 
 void Container::handleChildUpdated()
 {
-    updateSize();
-    Item::handleChildUpdated();
+    invalidateSize();
+}
+
+void Container::handleChildBoundsUpdated()
+{
+    m_childOverflow = glm::vec2{0.0f};
+    for (const auto &layoutItem : m_layoutItems)
+    {
+        const auto *item = layoutItem.item();
+        const auto rect = RectF{layoutItem.offset, layoutItem.offset + glm::vec2{item->width(), item->height()}};
+        m_childOverflow = glm::max(m_childOverflow, glm::max(rect.min - layoutItem.bounds.min,
+                                                             layoutItem.bounds.max - rect.max));
+    }
+}
+
+std::pair<std::size_t, std::size_t> Container::stackedChildRange(const RectF &clipRect, glm::length_t axis) const
+{
+    // with negative spacing the children overlap and their ends aren't sorted anymore
+    if (m_spacing < 0.0f)
+        return {0, m_layoutItems.size()};
+    const auto overflow = m_childOverflow[axis];
+    const auto first = std::partition_point(
+        m_layoutItems.begin(), m_layoutItems.end(), [&clipRect, axis, overflow](const LayoutItem &layoutItem) {
+            const auto size = layoutItem.item()->size();
+            const auto end = layoutItem.offset[axis] + (axis == 0 ? size.width : size.height);
+            return end + overflow <= clipRect.min[axis];
+        });
+    const auto last =
+        std::partition_point(first, m_layoutItems.end(), [&clipRect, axis, overflow](const LayoutItem &layoutItem) {
+            return layoutItem.offset[axis] - overflow < clipRect.max[axis];
+        });
+    return {static_cast<std::size_t>(std::distance(m_layoutItems.begin(), first)),
+            static_cast<std::size_t>(std::distance(m_layoutItems.begin(), last))};
 }
 
 void Column::setMinimumWidth(float width)
@@ -728,7 +1221,12 @@ void Column::setMinimumWidth(float width)
     if (width == m_minimumWidth)
         return;
     m_minimumWidth = width;
-    updateSize();
+    invalidateSize();
+}
+
+std::pair<std::size_t, std::size_t> Column::visibleChildRange(const RectF &clipRect) const
+{
+    return stackedChildRange(clipRect, 1);
 }
 
 void Column::updateSize()
@@ -780,7 +1278,12 @@ void Row::setMinimumHeight(float height)
     if (height == m_minimumHeight)
         return;
     m_minimumHeight = height;
-    updateSize();
+    invalidateSize();
+}
+
+std::pair<std::size_t, std::size_t> Row::visibleChildRange(const RectF &clipRect) const
+{
+    return stackedChildRange(clipRect, 0);
 }
 
 void Row::updateSize()
@@ -830,8 +1333,9 @@ void Row::updateLayout()
 ScrollArea::ScrollArea(float viewportWidth, float viewportHeight, std::unique_ptr<Item> contentItem)
     : m_contentItem(std::move(contentItem))
 {
-    updateSize();
-    marginsChangedSignal.connect([this](Margins) { updateSize(); });
+    adoptChild(m_contentItem.get());
+    invalidateSize();
+    marginsChangedSignal.connect([this](Margins) { invalidateSize(); });
 }
 
 ScrollArea::ScrollArea(std::unique_ptr<Item> contentItem)
@@ -876,6 +1380,7 @@ Item *ScrollArea::handleMouseEvent(const TouchEvent &event)
         m_viewportOffset = glm::max(m_viewportOffset, glm::vec2(m_viewportSize.width - m_contentItem->width(),
                                                                 m_viewportSize.height - m_contentItem->height()));
         m_viewportOffset = glm::min(m_viewportOffset, glm::vec2(0, 0));
+        invalidate();
         return this;
     }
     case TouchEvent::Type::Press:
@@ -894,28 +1399,235 @@ Item *ScrollArea::handleMouseEvent(const TouchEvent &event)
     }
 }
 
-std::vector<Item *> ScrollArea::children() const
+void ScrollArea::setViewportSize(Size size)
 {
-    auto children = Item::children();
-    children.insert(children.begin(), m_contentItem.get());
-    return children;
+    if (size == m_viewportSize)
+        return;
+    m_viewportSize = size;
+    invalidateSize();
 }
 
-void ScrollArea::setViewportSize(Size size)
+void ScrollArea::updateSize()
+{
+    float height = m_viewportSize.height + m_margins.top + m_margins.bottom;
+    float width = m_viewportSize.width + m_margins.left + m_margins.right;
+    setSize({width, height});
+}
+
+ListView::ListView(ListModel *model)
+{
+    marginsChangedSignal.connect([this](Margins) { invalidateSize(); });
+    setModel(model);
+}
+
+ListView::~ListView()
+{
+    m_modelResetConnection.disconnect();
+}
+
+void ListView::setModel(ListModel *model)
+{
+    if (model == m_model)
+        return;
+    m_modelResetConnection.disconnect();
+    m_model = model;
+    if (m_model)
+        m_modelResetConnection = m_model->modelResetSignal.connect([this] { resetDelegates(); });
+    // the delegates were created by the previous model
+    m_delegates.clear();
+    m_rowHeight.reset();
+    m_contentOffset = 0.0f;
+    invalidateLayout();
+}
+
+void ListView::setViewportSize(Size size)
 {
     if (size == m_viewportSize)
         return;
     m_viewportSize = size;
-    updateSize();
+    invalidateSize();
 }
 
-void ScrollArea::updateSize()
+void ListView::setSpacing(float spacing)
+{
+    if (spacing == m_spacing)
+        return;
+    m_spacing = spacing;
+    invalidateLayout();
+}
+
+void ListView::setContentOffset(float offset)
+{
+    if (offset == m_contentOffset)
+        return;
+    m_contentOffset = offset;
+    invalidateLayout();
+}
+
+void ListView::resetDelegates()
+{
+    for (auto &delegate : m_delegates)
+        delegate.row = NoRow;
+    m_rowHeight.reset();
+    invalidateLayout();
+}
+
+void ListView::update(float elapsed)
+{
+    Item::update(elapsed);
+    for (auto &delegate : m_delegates)
+    {
+        if (delegate.row != NoRow)
+            delegate.item->update(elapsed);
+    }
+}
+
+void ListView::updateSize()
 {
     float height = m_viewportSize.height + m_margins.top + m_margins.bottom;
     float width = m_viewportSize.width + m_margins.left + m_margins.right;
     setSize({width, height});
 }
 
+void ListView::updateLayout()
+{
+    Item::updateLayout();
+    bindDelegates();
+}
+
+float ListView::maxContentOffset(std::size_t rowCount) const
+{
+    const auto contentHeight = rowCount * rowStride() - m_spacing;
+    return std::max(contentHeight - m_viewportSize.height, 0.0f);
+}
+
+void ListView::bindDelegates()
+{
+    const auto rowCount = m_model ? m_model->rowCount() : 0;
+    if (rowCount == 0)
+    {
+        m_delegates.clear();
+        m_contentOffset = 0.0f;
+        return;
+    }
+
+    const auto createDelegate = [this] {
+        auto item = m_model->createDelegate();
+        adoptChild(item.get());
+        return Delegate{std::move(item), NoRow};
+    };
+
+    if (!m_rowHeight)
+    {
+        if (m_delegates.empty())
+            m_delegates.push_back(createDelegate());
+        auto &delegate = m_delegates.front();
+        m_model->bindDelegate(delegate.item.get(), 0);
+        delegate.row = 0;
+        m_rowHeight = delegate.item->height();
+    }
+
+    m_contentOffset = std::clamp(m_contentOffset, 0.0f, maxContentOffset(rowCount));
+
+    const auto stride = rowStride();
+    const auto visibleRows = static_cast<std::size_t>(std::ceil(m_viewportSize.height / stride)) + 1;
+    const auto delegateCount = std::min(rowCount, visibleRows + 2 * ExtraDelegates);
+    if (delegateCount != m_delegates.size())
+    {
+        // which delegate shows a row depends on how many there are
+        for (auto &delegate : m_delegates)
+            delegate.row = NoRow;
+        while (m_delegates.size() < delegateCount)
+            m_delegates.push_back(createDelegate());
+        m_delegates.resize(delegateCount);
+    }
+
+    const auto firstVisibleRow = static_cast<std::size_t>(m_contentOffset / stride);
+    const auto firstRow =
+        std::min(firstVisibleRow > ExtraDelegates ? firstVisibleRow - ExtraDelegates : 0, rowCount - delegateCount);
+    for (auto row = firstRow; row < firstRow + delegateCount; ++row)
+    {
+        auto &delegate = m_delegates[row % delegateCount];
+        if (delegate.row != row)
+        {
+            m_model->bindDelegate(delegate.item.get(), row);
+            delegate.row = row;
+        }
+    }
+}
+
+bool ListView::renderContents(Painter *painter, int depth)
+{
+    const auto viewportPos = glm::vec2(m_margins.left, m_margins.top);
+    const auto prevClipRect = painter->clipRect();
+    const auto viewportRect = RectF{viewportPos, viewportPos + glm::vec2(m_viewportSize.width, m_viewportSize.height)};
+    painter->setClipRect(prevClipRect ? prevClipRect->intersected(viewportRect) : viewportRect);
+
+    const auto stride = rowStride();
+    for (const auto &delegate : m_delegates)
+    {
+        if (delegate.row == NoRow)
+            continue;
+        const auto y = delegate.row * stride - m_contentOffset;
+        if (y + stride <= 0.0f || y >= m_viewportSize.height)
+            continue;
+        painter->pushTransform();
+        painter->translate(viewportPos + glm::vec2(0.0f, y));
+        delegate.item->render(painter, depth);
+        painter->popTransform();
+    }
+
+    painter->setClipRect(prevClipRect);
+
+    return true;
+}
+
+ListView::Delegate *ListView::delegateAt(const glm::vec2 &pos, glm::vec2 &delegatePos)
+{
+    const auto viewportPos = glm::vec2(m_margins.left, m_margins.top);
+    const auto y = pos.y - viewportPos.y;
+    if (y < 0.0f || y >= m_viewportSize.height)
+        return nullptr;
+    const auto stride = rowStride();
+    const auto row = static_cast<std::size_t>((y + m_contentOffset) / stride);
+    const auto it = std::ranges::find_if(m_delegates, [row](const auto &delegate) { return delegate.row == row; });
+    if (it == m_delegates.end())
+        return nullptr;
+    delegatePos = pos - viewportPos - glm::vec2(0.0f, row * stride - m_contentOffset);
+    return &*it;
+}
+
+Item *ListView::handleMouseEvent(const TouchEvent &event)
+{
+    const auto &pos = event.position;
+    switch (event.type)
+    {
+    case TouchEvent::Type::DragEnd:
+        return this;
+    case TouchEvent::Type::DragMove: {
+        setContentOffset(contentOffset() - pos.y);
+        return this;
+    }
+    case TouchEvent::Type::Press:
+    case TouchEvent::Type::Release:
+    case TouchEvent::Type::DragBegin: {
+        if (!rect().contains(pos))
+            return nullptr;
+        glm::vec2 delegatePos;
+        if (auto *delegate = delegateAt(pos, delegatePos); delegate)
+        {
+            TouchEvent childEvent = event;
+            childEvent.position = delegatePos;
+            if (auto *handler = delegate->item->mouseEvent(childEvent); handler)
+                return handler;
+        }
+        return event.type == TouchEvent::Type::DragBegin ? this : nullptr;
+    }
+    default:
+        return nullptr;
+    }
+}
+
 Switch::Switch()
     : Switch(Size{80, 32})
 {
@@ -930,11 +1642,14 @@ Switch::Switch(Size size)
 {
     setSize(size);
 
-    fillBackground = true;
-    shape = Shape::Capsule;
-    backgroundBrush = glm::vec4(0, 0, 0, 1);
+    m_fillBackground = true;
+    m_shape = Shape::Capsule;
+    m_backgroundBrush = glm::vec4(0, 0, 0, 1);
 
-    m_animation.valueChangedSignal.connect([this](float value) { m_indicatorPosition = value; });
+    m_animation.valueChangedSignal.connect([this](float value) {
+        m_indicatorPosition = value;
+        invalidate();
+    });
     m_animation.duration = 0.2f;
 }
 
@@ -978,12 +1693,6 @@ void Switch::setChecked(bool checked)
     toggledSignal(checked);
 }
 
-void Switch::update(float elapsed)
-{
-    Item::update(elapsed);
-    m_animation.update(elapsed);
-}
-
 bool Switch::renderContents(Painter *painter, int depth)
 {
     const float radius = 0.5f * m_size.height;
@@ -1006,7 +1715,7 @@ MultiLineText::MultiLineText(Font *font, std::u32string_view text)
     : m_font(font)
     , m_text(text)
 {
-    updateSize();
+    invalidateSize();
 }
 
 void MultiLineText::setFont(Font *font)
@@ -1014,7 +1723,7 @@ void MultiLineText::setFont(Font *font)
     if (font == m_font)
         return;
     m_font = font;
-    updateSize();
+    invalidateSize();
 }
 
 void MultiLineText::setText(std::u32string_view text)
@@ -1022,7 +1731,7 @@ void MultiLineText::setText(std::u32string_view text)
     if (text == m_text)
         return;
     m_text = text;
-    updateSize();
+    invalidateSize();
 }
 
 void MultiLineText::setMargins(Margins margins)
@@ -1030,7 +1739,7 @@ void MultiLineText::setMargins(Margins margins)
     if (margins == m_margins)
         return;
     m_margins = margins;
-    updateSize();
+    invalidateSize();
 }
 
 void MultiLineText::setFixedWidth(float width)
@@ -1038,7 +1747,7 @@ void MultiLineText::setFixedWidth(float width)
     if (width == m_fixedWidth)
         return;
     m_fixedWidth = width;
-    updateSize();
+    invalidateSize();
 }
 
 void MultiLineText::setFixedHeight(float height)
@@ -1046,11 +1755,20 @@ void MultiLineText::setFixedHeight(float height)
     if (height == m_fixedHeight)
         return;
     m_fixedHeight = height;
-    updateSize();
+    invalidateSize();
+}
+
+void MultiLineText::setAlignment(AlignmentFlags alignment)
+{
+    if (alignment == m_alignment)
+        return;
+    m_alignment = alignment;
+    invalidateSize();
 }
 
 void MultiLineText::updateSize()
 {
+    invalidate();
     breakTextLines();
     m_contentWidth = 0.0f;
     for (const auto &line : m_lines)
@@ -1062,6 +1780,7 @@ void MultiLineText::updateSize()
         return m_contentHeight + m_margins.top + m_margins.bottom;
     }();
     setSize({m_fixedWidth, height});
+    updateTextLayout();
 }
 
 bool MultiLineText::renderContents(Painter *painter, int depth)
@@ -1084,12 +1803,30 @@ bool MultiLineText::renderContents(Painter *painter, int depth)
         painter->setClipRect(prevClipRect ? prevClipRect->intersected(rect) : rect);
     }
 
+    painter->drawTextLayout(m_textLayout, glm::vec2(0.0f), depth);
+
+    if (clipped)
+        painter->setClipRect(prevClipRect);
+
+    return true;
+}
+
+void MultiLineText::updateTextLayout()
+{
+    m_textLayout.setFont(m_font);
+    m_textLayout.clear();
+
+    const auto availableWidth = m_size.width - (m_margins.left + m_margins.right);
+    const auto availableHeight = m_size.height - (m_margins.top + m_margins.bottom);
+    if (availableWidth < 0.0f || availableHeight < 0.0f)
+        return;
+
     const auto yOffset = [this, availableHeight] {
-        if (alignment.testFlag(Alignment::VCenter))
+        if (m_alignment.testFlag(Alignment::VCenter))
         {
             return 0.5f * (availableHeight - m_contentHeight);
         }
-        else if (alignment.testFlag(Alignment::Bottom))
+        else if (m_alignment.testFlag(Alignment::Bottom))
         {
             return availableHeight - m_contentHeight;
         }
@@ -1100,15 +1837,14 @@ bool MultiLineText::renderContents(Painter *painter, int depth)
         }
     }();
     auto textPos = glm::vec2(m_margins.left, m_margins.top) + glm::vec2(0.0f, yOffset);
-    painter->setFont(m_font);
     for (const auto &line : m_lines)
     {
         const auto offset = [this, &line, availableWidth] {
-            if (alignment.testFlag(Alignment::HCenter))
+            if (m_alignment.testFlag(Alignment::HCenter))
             {
                 return 0.5f * (availableWidth - line.width);
             }
-            else if (alignment.testFlag(Alignment::Right))
+            else if (m_alignment.testFlag(Alignment::Right))
             {
                 return availableWidth - line.width;
             }
@@ -1118,14 +1854,9 @@ bool MultiLineText::renderContents(Painter *painter, int depth)
                 return 0.0f;
             }
         }();
-        painter->drawText(line.text, textPos + glm::vec2(offset, 0), depth);
+        m_textLayout.addText(line.text, textPos + glm::vec2(offset, 0));
         textPos.y += m_font->pixelHeight();
     }
-
-    if (clipped)
-        painter->setClipRect(prevClipRect);
-
-    return true;
 }
 
 void MultiLineText::breakTextLines()
@@ -3,7 +3,10 @@
 #include "brush.h"
 #include "flags.h"
 #include "font.h"
+#include "nameregistry.h"
+#include "textlayout.h"
 #include "textureatlas.h"
+#include "transform.h"
 #include "touchevent.h"
 #include "tweening.h"
 #include "valueanimation.h"
@@ -12,17 +15,19 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <concepts>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace muui
 {
 class Painter;
 class ShaderEffect;
-class Transform;
 
 enum class Alignment : unsigned
 {
@@ -117,10 +122,23 @@ public:
     Item();
     virtual ~Item();
 
-    Size size() const { return m_size; }
-    float width() const { return m_size.width; }
-    float height() const { return m_size.height; }
-    RectF rect() const { return RectF{{0, 0}, {m_size.width, m_size.height}}; }
+    Size size() const
+    {
+        ensureLayout();
+        return m_size;
+    }
+    float width() const { return size().width; }
+    float height() const { return size().height; }
+    RectF rect() const
+    {
+        const auto size = this->size();
+        return RectF{{0, 0}, {size.width, size.height}};
+    }
+
+    // Computes the sizes and child positions changed since the last call, children first. Changes to the layout are
+    // only recorded when they're made, so that many of them cost a single pass. Screen::render() runs it, and so does
+    // querying a size or a child position.
+    void layout();
 
     void setMargins(Margins margins);
     Margins margins() const { return m_margins; }
@@ -128,6 +146,8 @@ public:
     void render(Painter *painter, int depth = 0);
 
     Item *mouseEvent(const TouchEvent &event);
+    // Visits the whole tree, only needed for items with per-frame work of their own. Animations are advanced by
+    // sys::animator().
     virtual void update(float elapsed);
 
     template<typename ChildT, typename... Args>
@@ -143,6 +163,8 @@ public:
     {
         auto it = m_layoutItems.emplace(std::next(m_layoutItems.begin(), index),
                                         std::make_unique<ChildT>(std::forward<Args>(args)...), this);
+        if (m_nameRegistry)
+            it->item()->setNameRegistry(m_nameRegistry);
         handleChildUpdated();
         return static_cast<ChildT *>(it->item());
     }
@@ -151,20 +173,48 @@ public:
     std::unique_ptr<Item> takeChildAt(std::size_t index);
     Item *childAt(std::size_t index) const;
     std::size_t childCount() const { return m_layoutItems.size(); }
-    virtual std::vector<Item *> children() const;
+    std::vector<Item *> children() const;
     RectF childRect(std::size_t index);
 
+    // Calls visitor with each child, including the ones managed by the item itself, which aren't in childAt(). The
+    // children can't be added or removed meanwhile.
+    template<typename VisitorT>
+    void forEachChild(VisitorT &&visitor) const
+    {
+        for (const auto &layoutItem : m_layoutItems)
+            visitor(layoutItem.item());
+        for (auto *child : m_adoptedChildren)
+            visitor(child);
+    }
+
+    // Returns the first match depth first, the item itself before its children. Looked up in the name registry of the
+    // screen if it has one, see Screen::setNameRegistryEnabled(), with the same result.
     template<typename ChildT>
         requires std::derived_from<ChildT, Item>
     ChildT *findChild(std::string_view name)
     {
-        if (auto *typedItem = dynamic_cast<ChildT *>(this); typedItem)
+        if (m_nameRegistry)
+        {
+            ChildT *result = nullptr;
+            for (auto *item : m_nameRegistry->items(name))
+            {
+                auto *typedItem = dynamic_cast<ChildT *>(item);
+                if (typedItem && isInSubtree(item) && (!result || item->precedes(result)))
+                    result = typedItem;
+            }
+            return result;
+        }
+        if (m_objectName == name)
         {
-            if (typedItem->objectName == name)
+            if (auto *typedItem = dynamic_cast<ChildT *>(this); typedItem)
                 return typedItem;
         }
-        const auto children = this->children();
-        for (auto *child : children)
+        for (const auto &layoutItem : m_layoutItems)
+        {
+            if (auto *result = layoutItem.item()->findChild<ChildT>(name); result)
+                return result;
+        }
+        for (auto *child : m_adoptedChildren)
         {
             if (auto *result = child->findChild<ChildT>(name); result)
                 return result;
@@ -193,8 +243,28 @@ public:
     void clearShaderEffect();
     ShaderEffect *shaderEffect() const;
 
-    std::string objectName;
-    bool visible = true;
+    Item *parent() const { return m_parent; }
+
+    // Marks the item as changed, so that it's drawn again with retained rendering and the area it covers is redrawn
+    // with partial updates. Setters already take care of it.
+    void invalidate();
+
+    // Window area covered by the item and its children, as of the last Screen::render() with partial updates
+    std::optional<RectF> bounds() const { return m_bounds; }
+
+    // Area covered by the item and its children, in the coordinates of the item
+    RectF subtreeBounds() const
+    {
+        ensureLayout();
+        return m_subtreeBounds;
+    }
+
+    void setObjectName(std::string_view name);
+    const std::string &objectName() const { return m_objectName; }
+
+    void setVisible(bool visible);
+    bool visible() const { return m_visible; }
+
     enum class Shape
     {
         Rectangle,
@@ -202,12 +272,23 @@ public:
         Circle,
         RoundedRectangle,
     };
-    Shape shape = Shape::Rectangle;
-    bool fillBackground = false;
-    std::optional<Brush> backgroundBrush;
-    std::optional<Brush> foregroundBrush;
-    std::optional<Brush> outlineBrush;
-    float cornerRadius = 0.0f;
+    void setShape(Shape shape);
+    Shape shape() const { return m_shape; }
+
+    void setFillBackground(bool fillBackground);
+    bool fillBackground() const { return m_fillBackground; }
+
+    void setBackgroundBrush(const std::optional<Brush> &brush);
+    const std::optional<Brush> &backgroundBrush() const { return m_backgroundBrush; }
+
+    void setForegroundBrush(const std::optional<Brush> &brush);
+    const std::optional<Brush> &foregroundBrush() const { return m_foregroundBrush; }
+
+    void setOutlineBrush(const std::optional<Brush> &brush);
+    const std::optional<Brush> &outlineBrush() const { return m_outlineBrush; }
+
+    void setCornerRadius(float radius);
+    float cornerRadius() const { return m_cornerRadius; }
 
     muslots::Signal<Size> resizedSignal;
     muslots::Signal<Margins> marginsChangedSignal;
@@ -246,11 +327,33 @@ protected:
     void setSize(Size size);
     void setHorizontalAnchor(const HorizontalAnchor &anchor);
     void setVerticalAnchor(const VerticalAnchor &anchor);
+    // Schedule updateSize() or updateLayout() for the next layout()
+    void invalidateSize();
+    void invalidateLayout();
+    void setLayoutPending();
+    void ensureLayout() const
+    {
+        if (m_layoutPending)
+            const_cast<Item *>(this)->layout();
+    }
+    // for items whose size depends on their contents
+    virtual void updateSize() {}
     virtual void updateLayout();
     bool renderBackground(Painter *painter, int depth);
     virtual bool renderContents(Painter *painter, int depth = 0);
+    // Range of m_layoutItems that can draw inside of clipRect, which is in the coordinates of the item. Children in the
+    // range are still culled one by one.
+    virtual std::pair<std::size_t, std::size_t> visibleChildRange(const RectF &clipRect) const;
+    // after the bounds of the children in m_layoutItems are updated
+    virtual void handleChildBoundsUpdated() {}
     virtual Item *handleMouseEvent(const TouchEvent &event);
     virtual void handleChildUpdated();
+    bool isInvalidated() const { return m_invalidated; }
+    // for children not in m_layoutItems, which don't have bounds of their own
+    void adoptChild(Item *child);
+    // registers the item and its children, or unregisters them if null
+    void setNameRegistry(NameRegistry *registry);
+    void updateBounds(const Transform &parentTransform, std::optional<RectF> &damage);
     Brush adjustBrushToRect(const Brush &brush, const Transform &transform) const;
 
     class LayoutItem
@@ -266,6 +369,7 @@ protected:
         LayoutItem &operator=(LayoutItem &&other) = default;
 
         glm::vec2 offset{0.0f};
+        RectF bounds; // subtree bounds of the item, in the coordinates of the parent
 
         Item *item() const { return m_item.get(); }
         std::unique_ptr<Item> takeItem() { return std::move(m_item); }
@@ -285,11 +389,48 @@ protected:
     std::vector<LayoutItem> m_layoutItems;
     HorizontalAnchor m_horizontalAnchor{};
     VerticalAnchor m_verticalAnchor{};
+    bool m_visible{true};
+    Shape m_shape{Shape::Rectangle};
+    bool m_fillBackground{false};
+    std::optional<Brush> m_backgroundBrush;
+    std::optional<Brush> m_foregroundBrush;
+    std::optional<Brush> m_outlineBrush;
+    float m_cornerRadius{0.0f};
 
 private:
+    struct RenderCache;
+    struct HitGrid;
+
+    // below this many children, testing the bounds of each one is cheaper than looking them up in a grid
+    static constexpr std::size_t HitGridMinChildren = 32;
+
+    void renderItem(Painter *painter, int depth);
     void doRender(Painter *painter, int depth);
+    bool isInSubtree(const Item *item) const;
+    bool precedes(const Item *item) const;
+    bool updateSubtreeBounds();
+    RectF transformedSubtreeBounds() const;
+    void invalidateSubtreeBounds();
+    void invalidateParentBounds();
 
     std::unique_ptr<ShaderEffect> m_effect;
+    Item *m_parent{nullptr};
+    bool m_adopted{false};
+    std::vector<Item *> m_adoptedChildren;
+    std::string m_objectName;
+    NameRegistry *m_nameRegistry{nullptr};
+    bool m_invalidated{true};
+    bool m_sizeInvalidated{false};
+    bool m_layoutInvalidated{false};
+    bool m_layoutPending{false}; // this item or a descendant has an invalidated size or layout
+    bool m_boundsInvalidated{false};
+    RectF m_subtreeBounds;
+    std::unique_ptr<HitGrid> m_hitGrid; // built on the first hit test after the bounds change
+    bool m_damaged{true};       // changed since the last updateBounds()
+    bool m_childDamaged{false}; // some descendant changed since the last updateBounds()
+    std::optional<RectF> m_bounds;
+    Transform m_boundsTransform; // parent transform m_bounds was computed with
+    std::unique_ptr<RenderCache> m_renderCache;
 
     friend class ShaderEffect;
 };
@@ -347,6 +488,7 @@ protected:
     glm::vec2 m_offset;
     float m_fixedWidth = -1;  // ignored if < 0
     float m_fixedHeight = -1; // ignored if < 0
+    TextLayout m_textLayout;
 };
 
 class Image : public Item
@@ -390,9 +532,12 @@ public:
 
 protected:
     void handleChildUpdated() override;
-    virtual void updateSize() = 0;
+    void handleChildBoundsUpdated() override;
+    // for children stacked along the given axis, 0 for x and 1 for y
+    std::pair<std::size_t, std::size_t> stackedChildRange(const RectF &clipRect, glm::length_t axis) const;
 
     float m_spacing = 0.0f;
+    glm::vec2 m_childOverflow{0.0f}; // how far the bounds of any child extend past its rect
 };
 
 class Column : public Container
@@ -401,6 +546,9 @@ public:
     void setMinimumWidth(float width);
     float minimumWidth() const { return m_minimumWidth; }
 
+protected:
+    std::pair<std::size_t, std::size_t> visibleChildRange(const RectF &clipRect) const override;
+
 private:
     void updateSize() override;
     void updateLayout() override;
@@ -414,6 +562,9 @@ public:
     void setMinimumHeight(float height);
     float minimumHeight() const { return m_minimumHeight; }
 
+protected:
+    std::pair<std::size_t, std::size_t> visibleChildRange(const RectF &clipRect) const override;
+
 private:
     void updateSize() override;
     void updateLayout() override;
@@ -427,8 +578,6 @@ public:
     explicit ScrollArea(std::unique_ptr<Item> contentItem);
     ScrollArea(float viewportWidth, float viewportHeight, std::unique_ptr<Item> contentItem);
 
-    std::vector<Item *> children() const override;
-
     void setViewportSize(Size size);
     Size viewportSize() const;
 
@@ -438,13 +587,87 @@ protected:
     Item *handleMouseEvent(const TouchEvent &event) override;
 
 private:
-    void updateSize();
+    void updateSize() override;
 
     std::unique_ptr<Item> m_contentItem;
     Size m_viewportSize;
     glm::vec2 m_viewportOffset = glm::vec2(0, 0);
 };
 
+// Rows shown by a ListView. The view only creates enough delegates to fill its viewport, and binds them to whatever
+// rows are visible.
+class ListModel
+{
+public:
+    virtual ~ListModel() = default;
+
+    virtual std::size_t rowCount() const = 0;
+    virtual std::unique_ptr<Item> createDelegate() = 0;
+    // Makes a delegate created by createDelegate() show the given row
+    virtual void bindDelegate(Item *delegate, std::size_t row) = 0;
+
+    // the row count or the contents of the rows changed
+    muslots::Signal<> modelResetSignal;
+};
+
+// Scrollable list of the rows of a ListModel, which must outlive the view. All rows have the height of the first
+// delegate.
+class ListView : public Item
+{
+public:
+    explicit ListView(ListModel *model = nullptr);
+    ~ListView() override;
+
+    void setModel(ListModel *model);
+    ListModel *model() const { return m_model; }
+
+    void setViewportSize(Size size);
+    Size viewportSize() const { return m_viewportSize; }
+
+    void setSpacing(float spacing);
+    float spacing() const { return m_spacing; }
+
+    // Distance from the top of the first row to the top of the viewport
+    void setContentOffset(float offset);
+    float contentOffset() const
+    {
+        ensureLayout();
+        return m_contentOffset;
+    }
+
+protected:
+    void update(float elapsed) override;
+    bool renderContents(Painter *painter, int depth = 0) override;
+    Item *handleMouseEvent(const TouchEvent &event) override;
+    void updateSize() override;
+    void updateLayout() override;
+
+private:
+    static constexpr std::size_t NoRow = ~std::size_t{0};
+    // delegates kept bound above and below the viewport, so that scrolling doesn't bind a row every frame
+    static constexpr std::size_t ExtraDelegates = 2;
+
+    struct Delegate
+    {
+        std::unique_ptr<Item> item;
+        std::size_t row{NoRow};
+    };
+
+    void resetDelegates();
+    void bindDelegates();
+    float rowStride() const { return std::max(m_rowHeight.value_or(0.0f) + m_spacing, 1.0f); }
+    float maxContentOffset(std::size_t rowCount) const;
+    Delegate *delegateAt(const glm::vec2 &pos, glm::vec2 &delegatePos);
+
+    ListModel *m_model{nullptr};
+    muslots::Connection m_modelResetConnection;
+    Size m_viewportSize;
+    float m_spacing{0.0f};
+    float m_contentOffset{0.0f};
+    std::optional<float> m_rowHeight; // measured on the first delegate
+    std::vector<Delegate> m_delegates; // row r is shown by m_delegates[r % m_delegates.size()]
+};
+
 class MultiLineText : public Item
 {
 public:
@@ -466,15 +689,18 @@ public:
     void setFixedHeight(float height);
     float fixedHeight() const { return m_fixedHeight; }
 
-    AlignmentFlags alignment = Alignment::VCenter | Alignment::Left;
+    void setAlignment(AlignmentFlags alignment);
+    AlignmentFlags alignment() const { return m_alignment; }
 
 protected:
     bool renderContents(Painter *painter, int depth = 0) override;
 
 private:
-    void updateSize();
+    void updateSize() override;
     void breakTextLines();
+    void updateTextLayout();
 
+    AlignmentFlags m_alignment = Alignment::VCenter | Alignment::Left;
     Font *m_font;
     std::u32string m_text;
     Margins m_margins;
@@ -488,6 +714,7 @@ private:
         float width;
     };
     std::vector<TextLine> m_lines;
+    TextLayout m_textLayout;
 };
 
 class Switch : public Item
@@ -506,7 +733,6 @@ public:
     muslots::Signal<bool> toggledSignal;
 
 protected:
-    void update(float elapsed) override;
     bool renderContents(Painter *painter, int depth = 0) override;
     Item *handleMouseEvent(const TouchEvent &event) override;
 
@@ -7,13 +7,8 @@ namespace muui
 
 LazyTexture::LazyTexture(const Pixmap *pixmap)
     : m_pixmap(pixmap)
-    , m_texture(pixmap->width, pixmap->height, pixmap->pixelType)
     , m_dirty(true)
 {
-    m_texture.setMinificationFilter(gl::Texture::Filter::Linear);
-    m_texture.setMagnificationFilter(gl::Texture::Filter::Linear);
-    m_texture.setWrapModeS(gl::Texture::WrapMode::Repeat);
-    m_texture.setWrapModeT(gl::Texture::WrapMode::Repeat);
 }
 
 void LazyTexture::markDirty()
@@ -23,12 +18,25 @@ void LazyTexture::markDirty()
 
 void LazyTexture::bind(int textureUnit) const
 {
+    upload();
+    m_texture->bind(textureUnit);
+}
+
+void LazyTexture::upload() const
+{
+    if (!m_texture)
+    {
+        m_texture = std::make_unique<gl::Texture>(m_pixmap->width, m_pixmap->height, m_pixmap->pixelType);
+        m_texture->setMinificationFilter(gl::Texture::Filter::Linear);
+        m_texture->setMagnificationFilter(gl::Texture::Filter::Linear);
+        m_texture->setWrapModeS(gl::Texture::WrapMode::Repeat);
+        m_texture->setWrapModeT(gl::Texture::WrapMode::Repeat);
+    }
     if (m_dirty)
     {
-        m_texture.setData(m_pixmap->pixels.data());
+        m_texture->setData(m_pixmap->pixels.data());
         m_dirty = false;
     }
-    m_texture.bind(textureUnit);
 }
 
 const Pixmap *LazyTexture::pixmap() const
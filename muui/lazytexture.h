@@ -3,6 +3,8 @@
 #include "abstracttexture.h"
 #include "texture.h"
 
+#include <memory>
+
 namespace muui
 {
 struct Pixmap;
@@ -15,12 +17,13 @@ public:
     void markDirty();
 
     void bind(int textureUnit = 0) const override;
+    void upload() const override;
 
     const Pixmap *pixmap() const;
 
 private:
     const Pixmap *m_pixmap;
-    gl::Texture m_texture;
+    mutable std::unique_ptr<gl::Texture> m_texture; // created when first bound, so that filling pages doesn't need GL
     mutable bool m_dirty;
 };
 
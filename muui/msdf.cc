@@ -0,0 +1,364 @@
+#include "msdf.h"
+
+#include "pixmap.h"
+
+#include <glm/glm.hpp>
+
+#include <stb_truetype.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace muui
+{
+
+namespace
+{
+
+// the channels an edge is the closest edge for
+enum EdgeColor : unsigned
+{
+    Red = 1,
+    Green = 2,
+    Blue = 4,
+    Yellow = Red | Green,
+    Magenta = Red | Blue,
+    Cyan = Green | Blue,
+    White = Red | Green | Blue,
+};
+
+struct Edge
+{
+    std::vector<glm::vec2> points; // curves are flattened
+    unsigned color{White};
+
+    glm::vec2 startDirection() const { return points[1] - points[0]; }
+    glm::vec2 endDirection() const { return points.back() - points[points.size() - 2]; }
+};
+using Contour = std::vector<Edge>;
+
+float cross(const glm::vec2 &a, const glm::vec2 &b)
+{
+    return a.x * b.y - a.y * b.x;
+}
+
+float median(const glm::vec3 &v)
+{
+    return std::max(std::min(v.r, v.g), std::min(std::max(v.r, v.g), v.b));
+}
+
+// in pixels, with y pointing down like in the pixmap
+std::vector<Contour> glyphContours(const stbtt_fontinfo &font, float scale, int codepoint)
+{
+    constexpr int CurveSegmentCount = 8;
+
+    stbtt_vertex *vertices = nullptr;
+    const int vertexCount = stbtt_GetCodepointShape(&font, codepoint, &vertices);
+
+    const auto point = [scale](int x, int y) { return glm::vec2(x * scale, -y * scale); };
+
+    std::vector<Contour> contours;
+    glm::vec2 position(0.0f);
+    for (int i = 0; i < vertexCount; ++i)
+    {
+        const auto &vertex = vertices[i];
+        const auto to = point(vertex.x, vertex.y);
+        Edge edge;
+        switch (vertex.type)
+        {
+        case STBTT_vmove:
+            contours.emplace_back();
+            break;
+        case STBTT_vline:
+            edge.points = {position, to};
+            break;
+        case STBTT_vcurve: {
+            const auto control = point(vertex.cx, vertex.cy);
+            edge.points.push_back(position);
+            for (int j = 1; j <= CurveSegmentCount; ++j)
+            {
+                const auto t = static_cast<float>(j) / CurveSegmentCount;
+                edge.points.push_back(glm::mix(glm::mix(position, control, t), glm::mix(control, to, t), t));
+            }
+            break;
+        }
+        case STBTT_vcubic: {
+            const auto control0 = point(vertex.cx, vertex.cy);
+            const auto control1 = point(vertex.cx1, vertex.cy1);
+            edge.points.push_back(position);
+            for (int j = 1; j <= CurveSegmentCount; ++j)
+            {
+                const auto t = static_cast<float>(j) / CurveSegmentCount;
+                const auto a = glm::mix(position, control0, t);
+                const auto b = glm::mix(control0, control1, t);
+                const auto c = glm::mix(control1, to, t);
+                edge.points.push_back(glm::mix(glm::mix(a, b, t), glm::mix(b, c, t), t));
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        // degenerate edges don't have a direction
+        if (!contours.empty() && edge.points.size() > 1 && edge.points.front() != edge.points.back())
+            contours.back().push_back(std::move(edge));
+        position = to;
+    }
+    stbtt_FreeShape(&font, vertices);
+
+    std::erase_if(contours, [](const Contour &contour) { return contour.empty(); });
+    return contours;
+}
+
+bool isCorner(const glm::vec2 &from, const glm::vec2 &to)
+{
+    // turns sharper than about 8 degrees, like msdfgen's default angle threshold of 3 radians
+    constexpr auto CrossThreshold = 0.14112f; // sin(3)
+    const auto a = glm::normalize(from);
+    const auto b = glm::normalize(to);
+    return glm::dot(a, b) <= 0.0f || std::abs(cross(a, b)) > CrossThreshold;
+}
+
+// Splits every edge in three, so that a contour with a single corner has enough edges to color
+Contour splitEdgesInThirds(const Contour &contour)
+{
+    Contour result;
+    for (const auto &edge : contour)
+    {
+        auto points = edge.points;
+        if (points.size() == 2)
+            points = {points[0], glm::mix(points[0], points[1], 1.0f / 3.0f),
+                      glm::mix(points[0], points[1], 2.0f / 3.0f), points[1]};
+        const auto last = points.size() - 1;
+        const std::array<std::size_t, 4> ends = {0, last / 3, 2 * last / 3, last};
+        for (std::size_t i = 0; i < 3; ++i)
+            result.push_back(Edge{.points = {points.begin() + ends[i], points.begin() + ends[i + 1] + 1}});
+    }
+    return result;
+}
+
+// The edges meeting at a corner get colors that share a single channel, so that the corner is where the median
+// switches between their distances. Smooth contours stay white.
+void colorEdges(Contour &contour)
+{
+    std::vector<std::size_t> corners;
+    for (std::size_t i = 0; i < contour.size(); ++i)
+    {
+        const auto &previous = contour[(i + contour.size() - 1) % contour.size()];
+        if (isCorner(previous.endDirection(), contour[i].startDirection()))
+            corners.push_back(i);
+    }
+    if (corners.empty())
+        return;
+
+    if (corners.size() == 1)
+    {
+        // a teardrop, the edges on either side of the corner get the two ends of the contour
+        std::rotate(contour.begin(), contour.begin() + corners.front(), contour.end());
+        if (contour.size() < 3)
+            contour = splitEdgesInThirds(contour);
+        constexpr std::array<unsigned, 3> colors = {Cyan, White, Yellow};
+        for (std::size_t i = 0; i < contour.size(); ++i)
+            contour[i].color = colors[3 * i / contour.size()];
+        return;
+    }
+
+    // the edges between two corners take turns, the last ones take the color that differs from both neighbours
+    constexpr std::array<unsigned, 3> colors = {Cyan, Magenta, Yellow};
+    const auto splineCount = corners.size();
+    for (std::size_t spline = 0; spline < splineCount; ++spline)
+    {
+        const auto color = spline == splineCount - 1 && spline % 3 == 0 ? colors[1] : colors[spline % 3];
+        for (auto i = corners[spline]; i != corners[(spline + 1) % splineCount]; i = (i + 1) % contour.size())
+            contour[i].color = color;
+    }
+}
+
+struct EdgeDistance
+{
+    float distance{std::numeric_limits<float>::max()}; // to the closest point of the edge
+    float orthogonality{0.0f}; // of the closest point, breaks ties between segments meeting there
+    const Edge *edge{nullptr};
+    std::size_t segment{0};
+    float t{0.0f};
+
+    bool operator<(const EdgeDistance &other) const
+    {
+        constexpr auto Epsilon = 1e-4f;
+        if (std::abs(distance - other.distance) <= Epsilon)
+            return orthogonality > other.orthogonality;
+        return distance < other.distance;
+    }
+};
+
+class DistanceField
+{
+public:
+    explicit DistanceField(std::vector<Contour> contours);
+
+    glm::vec3 distance(const glm::vec2 &p) const;
+
+private:
+    float side(const EdgeDistance &edgeDistance, const glm::vec2 &p) const;
+    float pseudoDistance(const EdgeDistance &edgeDistance, const glm::vec2 &p) const;
+
+    std::vector<Contour> m_contours;
+    float m_orientation;
+};
+
+DistanceField::DistanceField(std::vector<Contour> contours)
+    : m_contours(std::move(contours))
+{
+    // the filled side of the edges depends on the orientation of the outer contours, which are clockwise in TrueType
+    // fonts and counterclockwise in CFF fonts
+    float area = 0.0f;
+    for (auto &contour : m_contours)
+    {
+        colorEdges(contour);
+        for (const auto &edge : contour)
+        {
+            for (std::size_t i = 0; i + 1 < edge.points.size(); ++i)
+                area += cross(edge.points[i], edge.points[i + 1]);
+        }
+    }
+    m_orientation = area > 0.0f ? 1.0f : -1.0f;
+}
+
+float DistanceField::side(const EdgeDistance &edgeDistance, const glm::vec2 &p) const
+{
+    const auto &points = edgeDistance.edge->points;
+    const auto a = points[edgeDistance.segment];
+    const auto b = points[edgeDistance.segment + 1];
+    return m_orientation * cross(b - a, p - a) >= 0.0f ? 1.0f : -1.0f;
+}
+
+float DistanceField::pseudoDistance(const EdgeDistance &edgeDistance, const glm::vec2 &p) const
+{
+    const auto &points = edgeDistance.edge->points;
+    const auto a = points[edgeDistance.segment];
+    const auto b = points[edgeDistance.segment + 1];
+    // past the ends of an edge, the distance to its tangent is what makes the channels cross at the corners
+    const bool beforeStart = edgeDistance.segment == 0 && edgeDistance.t == 0.0f;
+    const bool afterEnd = edgeDistance.segment == points.size() - 2 && edgeDistance.t == 1.0f;
+    if (beforeStart || afterEnd)
+        return side(edgeDistance, p) * std::abs(cross(b - a, p - a)) / glm::length(b - a);
+    return side(edgeDistance, p) * edgeDistance.distance;
+}
+
+glm::vec3 DistanceField::distance(const glm::vec2 &p) const
+{
+    EdgeDistance closest;
+    std::array<EdgeDistance, 3> closestInChannel;
+    for (const auto &contour : m_contours)
+    {
+        for (const auto &edge : contour)
+        {
+            for (std::size_t i = 0; i + 1 < edge.points.size(); ++i)
+            {
+                const auto a = edge.points[i];
+                const auto ab = edge.points[i + 1] - a;
+                const auto lengthSquared = glm::dot(ab, ab);
+                if (lengthSquared == 0.0f)
+                    continue;
+                const auto t = std::clamp(glm::dot(p - a, ab) / lengthSquared, 0.0f, 1.0f);
+                const auto toPoint = p - (a + t * ab);
+                const auto distance = glm::length(toPoint);
+                const auto orthogonality =
+                    distance > 0.0f ? std::abs(cross(ab, toPoint)) / (std::sqrt(lengthSquared) * distance) : 0.0f;
+                const EdgeDistance edgeDistance{
+                    .distance = distance, .orthogonality = orthogonality, .edge = &edge, .segment = i, .t = t};
+                if (edgeDistance < closest)
+                    closest = edgeDistance;
+                for (std::size_t channel = 0; channel < 3; ++channel)
+                {
+                    if ((edge.color & (1u << channel)) && edgeDistance < closestInChannel[channel])
+                        closestInChannel[channel] = edgeDistance;
+                }
+            }
+        }
+    }
+
+    const auto trueDistance = side(closest, p) * closest.distance;
+    glm::vec3 result;
+    for (std::size_t channel = 0; channel < 3; ++channel)
+    {
+        const auto &edgeDistance = closestInChannel[channel];
+        result[channel] = edgeDistance.edge ? pseudoDistance(edgeDistance, p) : trueDistance;
+    }
+    // where the median is on the wrong side of the outline, e.g. where contours overlap, it would draw a false edge
+    if ((median(result) > 0.0f) != (trueDistance > 0.0f))
+        result = glm::vec3(trueDistance);
+    return result;
+}
+
+// Whether interpolating between neighbouring texels would make the median cross the edge between them, as msdfgen's
+// legacy error correction. Only the texel farther from the outline is flagged.
+bool clashes(const glm::vec3 &a, const glm::vec3 &b)
+{
+    constexpr auto Threshold = 1.001f; // distances can't change by more than a pixel from texel to texel
+    std::array<std::pair<float, float>, 3> channels = {{{a.r, b.r}, {a.g, b.g}, {a.b, b.b}}};
+    std::sort(channels.begin(), channels.end(), [](const auto &lhs, const auto &rhs) {
+        return std::abs(lhs.second - lhs.first) > std::abs(rhs.second - rhs.first);
+    });
+    const auto equalized = b.r == b.g && b.r == b.b;
+    return std::abs(channels[1].second - channels[1].first) >= Threshold && !equalized &&
+           std::abs(channels[2].first) >= std::abs(channels[2].second);
+}
+
+} // namespace
+
+Pixmap codepointMsdf(const stbtt_fontinfo &font, float scale, int codepoint, int padding, unsigned char onEdgeValue,
+                     float pixelDistScale)
+{
+    auto contours = glyphContours(font, scale, codepoint);
+    if (contours.empty())
+        return {};
+    const DistanceField distanceField(std::move(contours));
+
+    int x0, y0, x1, y1;
+    stbtt_GetCodepointBitmapBox(&font, codepoint, scale, scale, &x0, &y0, &x1, &y1);
+    const auto width = x1 - x0 + 2 * padding;
+    const auto height = y1 - y0 + 2 * padding;
+
+    std::vector<glm::vec3> distances(width * height);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const auto p = glm::vec2(x0 - padding + x, y0 - padding + y) + glm::vec2(0.5f);
+            distances[y * width + x] = distanceField.distance(p);
+        }
+    }
+
+    std::vector<bool> clashing(distances.size(), false);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const auto index = y * width + x;
+            if ((x > 0 && clashes(distances[index], distances[index - 1])) ||
+                (x < width - 1 && clashes(distances[index], distances[index + 1])) ||
+                (y > 0 && clashes(distances[index], distances[index - width])) ||
+                (y < height - 1 && clashes(distances[index], distances[index + width])))
+                clashing[index] = true;
+        }
+    }
+
+    Pixmap pixmap(width, height, PixelType::RGB);
+    auto *pixel = pixmap.pixels.data();
+    for (std::size_t i = 0; i < distances.size(); ++i)
+    {
+        const auto distance = clashing[i] ? glm::vec3(median(distances[i])) : distances[i];
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            const auto value = onEdgeValue + pixelDistScale * distance[channel];
+            *pixel++ = static_cast<unsigned char>(std::clamp(value, 0.0f, 255.0f));
+        }
+    }
+    return pixmap;
+}
+
+} // namespace muui
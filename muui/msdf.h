@@ -0,0 +1,17 @@
+#pragma once
+
+struct stbtt_fontinfo;
+
+namespace muui
+{
+struct Pixmap;
+
+// Renders the multi-channel signed distance field of a glyph, after "Shape Decomposition for Multi-channel Distance
+// Fields" (Chlumsky, 2015). The edges of the outline are split between the three channels so that their median is
+// the signed distance to the outline, except that corners stay sharp at any scale.
+// The parameters and the size of the RGB pixmap are those of stbtt_GetCodepointSDF(). The pixmap is invalid if the
+// glyph has no outline.
+Pixmap codepointMsdf(const stbtt_fontinfo &font, float scale, int codepoint, int padding, unsigned char onEdgeValue,
+                     float pixelDistScale);
+
+} // namespace muui
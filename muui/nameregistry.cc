@@ -0,0 +1,47 @@
+#include "nameregistry.h"
+
+#include "item.h"
+
+#include <algorithm>
+
+namespace muui
+{
+
+void NameRegistry::add(Item *item)
+{
+    const auto &name = item->objectName();
+    if (name.empty())
+        return;
+    auto it = m_items.find(name);
+    if (it == m_items.end())
+        it = m_items.emplace(name, std::vector<Item *>{}).first;
+    it->second.push_back(item);
+}
+
+void NameRegistry::remove(Item *item)
+{
+    const auto &name = item->objectName();
+    if (name.empty())
+        return;
+    auto it = m_items.find(name);
+    if (it == m_items.end())
+        return;
+    auto &items = it->second;
+    if (auto itemIt = std::find(items.begin(), items.end(), item); itemIt != items.end())
+    {
+        *itemIt = items.back();
+        items.pop_back();
+    }
+    if (items.empty())
+        m_items.erase(it);
+}
+
+std::span<Item *const> NameRegistry::items(std::string_view name) const
+{
+    auto it = m_items.find(name);
+    if (it == m_items.end())
+        return {};
+    return it->second;
+}
+
+} // namespace muui
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace muui
+{
+class Item;
+
+// Items of a Screen by objectName, so that finding one doesn't walk the tree. Each name is stored once, and looking
+// one up doesn't copy it.
+class NameRegistry : private NonCopyable
+{
+public:
+    void add(Item *item);
+    void remove(Item *item);
+
+    // in no particular order
+    std::span<Item *const> items(std::string_view name) const;
+
+private:
+    struct StringHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    std::unordered_map<std::string, std::vector<Item *>, StringHash, std::equal_to<>> m_items;
+};
+
+} // namespace muui
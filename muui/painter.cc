@@ -2,7 +2,10 @@
 
 #include "font.h"
 #include "gradienttexture.h"
+#include "renderstats.h"
 #include "spritebatcher.h"
+#include "system.h"
+#include "textlayout.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/matrix_transform_2d.hpp>
@@ -39,6 +42,7 @@ void Painter::begin()
     m_outlineBrush.reset();
     m_spriteBatcher->begin();
     m_clipRect.reset();
+    ++sys::renderStats()->frames;
 }
 
 void Painter::end()
@@ -46,6 +50,36 @@ void Painter::end()
     m_spriteBatcher->flush();
 }
 
+void Painter::setRetainedRendering(bool enabled)
+{
+    m_retainedRendering = enabled;
+    m_spriteBatcher->setFrameRetained(enabled);
+}
+
+bool Painter::resubmitFrame()
+{
+    if (!m_spriteBatcher->resubmitFrame())
+        return false;
+    ++sys::renderStats()->resubmittedFrames;
+    return true;
+}
+
+void Painter::beginRecording(RenderList *list)
+{
+    m_spriteBatcher->beginRecording(list);
+}
+
+void Painter::endRecording()
+{
+    m_spriteBatcher->endRecording();
+}
+
+void Painter::replay(const RenderList &list)
+{
+    m_spriteBatcher->replay(list);
+    ++sys::renderStats()->replayedLists;
+}
+
 void Painter::pushTransform()
 {
     m_transformStack.push({m_spriteBatcher->transform(), m_clipRect});
@@ -125,6 +159,11 @@ void Painter::setClipRect(const std::optional<RectF> &rect)
     m_clipRect = rect;
 }
 
+void Painter::setDamageRect(const std::optional<RectF> &rect)
+{
+    m_damageRect = rect;
+}
+
 void Painter::drawRect(const RectF &rect, int depth)
 {
     if (!m_clipRect || m_clipRect->intersects(rect))
@@ -196,12 +235,51 @@ void Painter::drawGlyph(const Font::Glyph *glyph, const glm::vec2 &pos, bool out
         m_spriteBatcher->setBatchTexture(pixmap.texture);
         const auto topLeftVertex = VertexUV{.position = topLeft, .texCoord = pixmap.texCoord.min};
         const auto bottomRightVertex = VertexUV{.position = bottomRight, .texCoord = pixmap.texCoord.max};
-        std::visit([this, &topLeftVertex, &bottomRightVertex,
-                    depth](const auto &brush) { addSprite(topLeftVertex, bottomRightVertex, brush, depth); },
+        const auto edge = outline ? m_font->outlineEdge() : m_font->glyphEdge(); // only read by distance field shaders
+        std::visit([this, &topLeftVertex, &bottomRightVertex, edge,
+                    depth](const auto &brush) { addTextSprite(topLeftVertex, bottomRightVertex, brush, edge, depth); },
                    *brush);
+        ++sys::renderStats()->glyphs;
     }
 }
 
+void Painter::drawTextLayout(const TextLayout &layout, const glm::vec2 &pos, int depth)
+{
+    setFont(layout.font());
+    assert(m_font);
+    if (layout.isEmpty() || (m_clipRect && !m_clipRect->intersects(layout.bounds() + pos)))
+        return;
+    if (m_font->outlineSize() > 0)
+    {
+        drawTextLayout(layout, pos, true, depth);
+        drawTextLayout(layout, pos, false, depth + 1);
+    }
+    else
+    {
+        drawTextLayout(layout, pos, false, depth);
+    }
+}
+
+void Painter::drawTextLayout(const TextLayout &layout, const glm::vec2 &pos, bool outline, int depth)
+{
+    const auto &brush = outline ? m_outlineBrush : m_foregroundBrush;
+    assert(brush);
+    const auto edge = outline ? m_font->outlineEdge() : m_font->glyphEdge();
+    std::visit(
+        [this, &layout, &pos, outline, edge, depth](const auto &brush) {
+            setTextProgram(brush, outline);
+            for (const auto &glyph : layout.glyphs())
+            {
+                m_spriteBatcher->setBatchTexture(glyph.texture);
+                const auto topLeft = VertexUV{.position = pos + glyph.rect.min, .texCoord = glyph.texCoord.min};
+                const auto bottomRight = VertexUV{.position = pos + glyph.rect.max, .texCoord = glyph.texCoord.max};
+                addTextSprite(topLeft, bottomRight, brush, edge, depth);
+            }
+        },
+        *brush);
+    sys::renderStats()->glyphs += layout.glyphs().size();
+}
+
 void Painter::drawCircle(const glm::vec2 &center, float radius, int depth)
 {
     const auto topLeft = center - glm::vec2(radius, radius);
@@ -268,14 +346,35 @@ void Painter::setDecalProgram(const LinearGradient &gradient)
 
 void Painter::setTextProgram(const Color &, bool outline)
 {
-    const auto program = outline ? ShaderManager::ProgramHandle::TextOutline : ShaderManager::ProgramHandle::Text;
+    // distance field fonts draw the outline with the same program, at a different edge
+    const auto program = [this, outline] {
+        switch (m_font->distanceField())
+        {
+        case Font::DistanceField::SingleChannel:
+            return ShaderManager::ProgramHandle::TextDistanceField;
+        case Font::DistanceField::MultiChannel:
+            return ShaderManager::ProgramHandle::TextMsdf;
+        default:
+            return outline ? ShaderManager::ProgramHandle::TextOutline : ShaderManager::ProgramHandle::Text;
+        }
+    }();
     m_spriteBatcher->setBatchProgram(program);
 }
 
 void Painter::setTextProgram(const LinearGradient &gradient, bool outline)
 {
-    const auto program =
-        outline ? ShaderManager::ProgramHandle::TextGradientOutline : ShaderManager::ProgramHandle::TextGradient;
+    const auto program = [this, outline] {
+        switch (m_font->distanceField())
+        {
+        case Font::DistanceField::SingleChannel:
+            return ShaderManager::ProgramHandle::TextGradientDistanceField;
+        case Font::DistanceField::MultiChannel:
+            return ShaderManager::ProgramHandle::TextGradientMsdf;
+        default:
+            return outline ? ShaderManager::ProgramHandle::TextGradientOutline
+                           : ShaderManager::ProgramHandle::TextGradient;
+        }
+    }();
     m_spriteBatcher->setBatchProgram(program);
     m_spriteBatcher->setBatchGradientTexture(gradient.texture);
 }
@@ -331,6 +430,21 @@ void Painter::addRoundedRectSprite(const VertexT &topLeft, const VertexT &bottom
               glm::vec4(size, radius, 0), depth);
 }
 
+template<typename VertexT>
+void Painter::addTextSprite(const VertexT &topLeft, const VertexT &bottomRight, const Color &color, float edge,
+                            int depth)
+{
+    addSprite(topLeft, bottomRight, color, glm::vec4(edge, 0, 0, 0), depth);
+}
+
+template<typename VertexT>
+void Painter::addTextSprite(const VertexT &topLeft, const VertexT &bottomRight, const LinearGradient &gradient,
+                            float edge, int depth)
+{
+    addSprite(topLeft, bottomRight, glm::vec4(gradient.start.x, gradient.start.y, gradient.end.x, gradient.end.y),
+              glm::vec4(edge, 0, 0, 0), depth);
+}
+
 void Painter::addSprite(const Vertex &topLeft, const Vertex &bottomRight, const glm::vec4 &fgColor,
                         const glm::vec4 &bgColor, int depth)
 {
@@ -16,7 +16,9 @@
 
 namespace muui
 {
+class RenderList;
 class SpriteBatcher;
+class TextLayout;
 struct PackedPixmap;
 
 class Painter : private NonCopyable
@@ -33,6 +35,16 @@ public:
     void begin();
     void end();
 
+    // In retained mode items record what they draw and replay it on the next frames until they're invalidated, and
+    // frames where nothing changed are resubmitted as they are.
+    void setRetainedRendering(bool enabled);
+    bool retainedRendering() const { return m_retainedRendering; }
+    bool resubmitFrame();
+
+    void beginRecording(RenderList *list);
+    void endRecording();
+    void replay(const RenderList &list);
+
     const Transform &transform() const;
 
     void translate(const glm::vec2 &pos);
@@ -57,12 +69,18 @@ public:
     void setClipRect(const std::optional<RectF> &rect);
     std::optional<RectF> clipRect() const { return m_clipRect; }
 
+    // Window area being redrawn, items entirely outside of it can be skipped
+    void setDamageRect(const std::optional<RectF> &rect);
+    std::optional<RectF> damageRect() const { return m_damageRect; }
+
     SpriteBatcher *spriteBatcher() const { return m_spriteBatcher.get(); }
 
     void drawRect(const RectF &rect, int depth);
     void drawPixmap(const PackedPixmap &pixmap, const RectF &rect, int depth);
     void drawText(std::u32string_view text, const glm::vec2 &pos, int depth);
     void drawGlyph(const Font::Glyph *glyph, const glm::vec2 &pos, bool outline, int depth);
+    // Draws the layout with its font, which becomes the current font
+    void drawTextLayout(const TextLayout &layout, const glm::vec2 &pos, int depth);
     void drawCircle(const glm::vec2 &center, float radius, int depth);
     void drawCapsule(const RectF &rect, int depth);
     void drawRoundedRect(const RectF &rect, float cornerRadius, int depth);
@@ -80,6 +98,7 @@ private:
     };
 
     void drawText(std::u32string_view text, const glm::vec2 &pos, bool outline, int depth);
+    void drawTextLayout(const TextLayout &layout, const glm::vec2 &pos, bool outline, int depth);
     void setRectProgram(const Color &color);
     void setRectProgram(const LinearGradient &gradient);
 
@@ -109,6 +128,13 @@ private:
     void addRoundedRectSprite(const VertexT &topLeft, const VertexT &bottomRight, const LinearGradient &gradient,
                               const glm::vec2 &size, float radius, int depth);
 
+    template<typename VertexT>
+    void addTextSprite(const VertexT &topLeft, const VertexT &bottomRight, const Color &color, float edge, int depth);
+
+    template<typename VertexT>
+    void addTextSprite(const VertexT &topLeft, const VertexT &bottomRight, const LinearGradient &gradient, float edge,
+                       int depth);
+
     void addSprite(const Vertex &topLeft, const Vertex &bottomRight, const glm::vec4 &fgColor, const glm::vec4 &bgColor,
                    int depth);
     void addSprite(const VertexUV &topLeft, const VertexUV &bottomRight, const glm::vec4 &fgColor,
@@ -125,7 +151,9 @@ private:
     std::optional<Brush> m_foregroundBrush; // pixmap, text
     std::optional<Brush> m_outlineBrush;    // text outline
     std::optional<RectF> m_clipRect;
+    std::optional<RectF> m_damageRect;
     bool m_clippingEnabled{false};
+    bool m_retainedRendering{false};
     struct TransformClipRect
     {
         Transform transform;
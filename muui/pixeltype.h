@@ -6,7 +6,8 @@ enum class PixelType
 {
     Invalid,
     RGBA,
-    Grayscale
+    Grayscale,
+    RGB
 };
 
 constexpr std::size_t pixelSizeInBytes(PixelType pixelType)
@@ -16,6 +17,9 @@ constexpr std::size_t pixelSizeInBytes(PixelType pixelType)
     case PixelType::RGBA:
         return 4;
 
+    case PixelType::RGB:
+        return 3;
+
     case PixelType::Grayscale:
     case PixelType::Invalid:
     default:
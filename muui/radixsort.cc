@@ -0,0 +1,53 @@
+#include "radixsort.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace muui
+{
+
+void radixSort(std::span<std::uint64_t> keys, std::vector<std::uint64_t> &scratch)
+{
+    constexpr int DigitBits = 8;
+    constexpr int BucketCount = 1 << DigitBits;
+    constexpr int PassCount = 64 / DigitBits;
+
+    const auto count = keys.size();
+    if (count < 2)
+        return;
+
+    std::array<std::array<std::size_t, BucketCount>, PassCount> histograms{};
+    for (const auto key : keys)
+    {
+        for (int pass = 0; pass < PassCount; ++pass)
+            ++histograms[pass][(key >> (pass * DigitBits)) & (BucketCount - 1)];
+    }
+
+    scratch.resize(count);
+    auto *src = keys.data();
+    auto *dest = scratch.data();
+    for (int pass = 0; pass < PassCount; ++pass)
+    {
+        const auto shift = pass * DigitBits;
+        auto &histogram = histograms[pass];
+        if (histogram[(src[0] >> shift) & (BucketCount - 1)] == count)
+            continue;
+
+        std::size_t offset = 0;
+        for (auto &bucket : histogram)
+            offset += std::exchange(bucket, offset);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto key = src[i];
+            dest[histogram[(key >> shift) & (BucketCount - 1)]++] = key;
+        }
+        std::swap(src, dest);
+    }
+
+    if (src != keys.data())
+        std::copy(src, src + count, keys.data());
+}
+
+} // namespace muui
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace muui
+{
+
+// LSD radix sort on 64-bit keys, one byte per pass. Passes where all the keys share the same digit are skipped.
+// `scratch` is resized to the number of keys and can be reused between calls to avoid allocations.
+void radixSort(std::span<std::uint64_t> keys, std::vector<std::uint64_t> &scratch);
+
+} // namespace muui
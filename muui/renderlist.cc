@@ -0,0 +1,14 @@
+#include "renderlist.h"
+
+namespace muui
+{
+
+void RenderList::clear()
+{
+    m_commands.clear();
+    m_sprites.clear();
+    m_instances.clear();
+    m_children.clear();
+}
+
+} // namespace muui
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "spritebatcher.h"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace muui
+{
+
+// Sprites recorded by a SpriteBatcher, with the state and depth they were added with, so that they can be submitted
+// again without redoing the work that produced them.
+class RenderList : private NonCopyable
+{
+public:
+    void clear();
+    bool empty() const { return m_commands.empty() && m_children.empty(); }
+
+private:
+    struct Command
+    {
+        SpriteBatcher::BatchState state;
+        const AbstractTexture *texture; // if state.multiTexture
+        int depth;
+        std::size_t index; // in m_sprites or m_instances, depending on state.instanced
+    };
+
+    std::vector<Command> m_commands;
+    std::vector<std::array<SpriteBatcher::SpriteVertex, 4>> m_sprites;
+    std::vector<SpriteBatcher::SpriteInstance> m_instances;
+    // nested recordings, replayed before the command at the given index
+    std::vector<std::pair<std::size_t, const RenderList *>> m_children;
+
+    friend class SpriteBatcher;
+};
+
+} // namespace muui
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+namespace muui
+{
+
+// Counters for what it took to render a frame. Painter and SpriteBatcher add to sys::renderStats(), which Application
+// resets at the start of each frame.
+struct RenderStats
+{
+    int frames{0};            // frames started with Painter::begin()
+    int resubmittedFrames{0}; // retained frames drawn again with Painter::resubmitFrame()
+    int replayedLists{0};
+    int glyphs{0};
+
+    std::size_t quads{0}; // sprites submitted to SpriteBatcher::flush()
+    int flushes{0};
+    int batches{0};
+    int mergedBatches{0};
+    int drawCalls{0};
+    int programSwitches{0};
+    int textureBinds{0};
+    int blendChanges{0}; // blend functions, and blending toggled for the opaque pass
+    std::size_t bytesMapped{0};
+    std::size_t bytesUploaded{0}; // mapped vertex data plus buffers reallocated with new contents
+
+    // Why each draw call after the first one of a flush was issued. A draw is counted once, with the first reason
+    // that applies in this order.
+    int textureLimitBreaks{0};    // ran out of texture units in a multi-texture batch
+    int passBreaks{0};            // switched between opaque and translucent sprites
+    int depthBreaks{0};           // state already drawn earlier, split off because of the depth order
+    int programBreaks{0};         // includes the variants of a program
+    int blendFuncBreaks{0};
+    int textureBreaks{0};
+    int gradientTextureBreaks{0};
+};
+
+} // namespace muui
@@ -0,0 +1,46 @@
+#include "renderstatsoverlay.h"
+
+#include "renderstats.h"
+
+#include <fmt/core.h>
+
+#include <string>
+
+namespace muui
+{
+
+namespace
+{
+constexpr auto LineCount = 6;
+}
+
+RenderStatsOverlay::RenderStatsOverlay(Font *font)
+{
+    setMargins({8, 8, 8, 8});
+    m_fillBackground = true;
+    m_backgroundBrush = Color(0, 0, 0, 0.6);
+    m_foregroundBrush = Color(1, 1, 1, 1);
+    for (int i = 0; i < LineCount; ++i)
+        m_lines.push_back(appendChild<Label>(font));
+}
+
+void RenderStatsOverlay::setStats(const RenderStats &stats, float framesPerSecond)
+{
+    const std::string lines[] = {
+        fmt::format("fps: {:.1f}  frames: {}  resubmitted: {}", framesPerSecond, stats.frames, stats.resubmittedFrames),
+        fmt::format("quads: {}  glyphs: {}  replayed lists: {}", stats.quads, stats.glyphs, stats.replayedLists),
+        fmt::format("flushes: {}  batches: {}  merged: {}  draw calls: {}", stats.flushes, stats.batches,
+                    stats.mergedBatches, stats.drawCalls),
+        fmt::format("program switches: {}  texture binds: {}  blend changes: {}", stats.programSwitches,
+                    stats.textureBinds, stats.blendChanges),
+        fmt::format("mapped: {} KiB  uploaded: {} KiB", stats.bytesMapped / 1024, stats.bytesUploaded / 1024),
+        fmt::format("breaks: texture {}  gradient {}  program {}  blend {}  depth {}  pass {}  texture limit {}",
+                    stats.textureBreaks, stats.gradientTextureBreaks, stats.programBreaks, stats.blendFuncBreaks,
+                    stats.depthBreaks, stats.passBreaks, stats.textureLimitBreaks),
+    };
+    static_assert(std::size(lines) == LineCount);
+    for (int i = 0; i < LineCount; ++i)
+        m_lines[i]->setText(std::u32string(lines[i].begin(), lines[i].end()));
+}
+
+} // namespace muui
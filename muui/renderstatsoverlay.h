@@ -0,0 +1,23 @@
+#pragma once
+
+#include "item.h"
+
+#include <vector>
+
+namespace muui
+{
+struct RenderStats;
+
+// Debug overlay with the render stats of a frame, typically Application::renderStats() updated once per frame.
+class RenderStatsOverlay : public Column
+{
+public:
+    explicit RenderStatsOverlay(Font *font);
+
+    void setStats(const RenderStats &stats, float framesPerSecond);
+
+private:
+    std::vector<Label *> m_lines;
+};
+
+} // namespace muui
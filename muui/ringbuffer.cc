@@ -0,0 +1,134 @@
+#include "ringbuffer.h"
+
+#include "log.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace muui::gl
+{
+
+namespace
+{
+constexpr GLuint64 FenceTimeout = 1000000; // in nanoseconds
+}
+
+RingBuffer::RingBuffer(Buffer::Type type, std::size_t regionCount)
+    : m_buffer(type, Buffer::Usage::StreamDraw)
+    , m_fences(regionCount, nullptr)
+{
+    assert(regionCount > 0);
+}
+
+RingBuffer::~RingBuffer()
+{
+    deleteFences();
+}
+
+void RingBuffer::bind() const
+{
+    m_buffer.bind();
+}
+
+void RingBuffer::allocate(std::size_t regionSize)
+{
+    // the old storage is orphaned, so there's nothing left to wait for
+    deleteFences();
+    m_regionSize = (regionSize + Alignment - 1) & ~(Alignment - 1);
+    m_buffer.bind();
+    m_buffer.allocate(m_regionSize * m_fences.size());
+    m_region = 0;
+    m_writeOffset = 0;
+}
+
+void RingBuffer::release()
+{
+    if (m_regionSize == 0)
+        return;
+    deleteFences();
+    m_buffer.bind();
+    m_buffer.allocate(0);
+    m_regionSize = 0;
+    m_region = 0;
+    m_writeOffset = 0;
+}
+
+void RingBuffer::nextRegion()
+{
+    m_region = (m_region + 1) % m_fences.size();
+    m_writeOffset = 0;
+
+    auto &fence = m_fences[m_region];
+    if (!fence)
+        return;
+    for (;;)
+    {
+        const auto result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout);
+        if (result != GL_TIMEOUT_EXPIRED)
+        {
+            if (result == GL_WAIT_FAILED)
+                log_error("Failed to wait for ring buffer fence");
+            break;
+        }
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+std::byte *RingBuffer::map(std::size_t size)
+{
+    if (m_writeOffset + size > m_regionSize)
+    {
+        auto regionSize = std::max<std::size_t>(m_regionSize, Alignment);
+        while (regionSize < m_writeOffset + size)
+            regionSize *= 2;
+        allocate(regionSize);
+    }
+
+    m_mappedOffset = m_region * m_regionSize + m_writeOffset;
+    m_writeOffset = (m_writeOffset + size + Alignment - 1) & ~(Alignment - 1);
+
+    m_buffer.bind();
+    // The region can't be in use by the GPU thanks to the fences. On WebGL mapping is emulated with bufferSubData, so
+    // there's nothing to synchronize in the first place.
+    auto *data = m_buffer.mapRange<std::byte>(m_mappedOffset, size,
+                                              Buffer::Access::Write
+#if defined(__EMSCRIPTEN__)
+                                                  | Buffer::Access::InvalidateRange
+#else
+                                                  | Buffer::Access::Unsynchronized
+#endif
+    );
+    if (!data)
+        log_error("Failed to map ring buffer range");
+    return data;
+}
+
+void RingBuffer::unmap()
+{
+    m_buffer.unmap();
+}
+
+void RingBuffer::fence()
+{
+#if !defined(__EMSCRIPTEN__)
+    auto &fence = m_fences[m_region];
+    if (fence)
+        glDeleteSync(fence); // the new fence covers everything the old one did
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+}
+
+void RingBuffer::deleteFences()
+{
+    for (auto &fence : m_fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+}
+
+} // namespace muui::gl
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "buffer.h"
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace muui::gl
+{
+
+// Streaming buffer split in a number of regions, one per frame in flight. Data for a frame is appended to the current
+// region, and a fence makes sure a region isn't written to again before the GPU is done reading from it.
+class RingBuffer : private NonCopyable
+{
+public:
+    static constexpr std::size_t DefaultRegionCount = 3;
+    static constexpr std::size_t Alignment = 16;
+
+    explicit RingBuffer(Buffer::Type type, std::size_t regionCount = DefaultRegionCount);
+    ~RingBuffer();
+
+    void bind() const;
+
+    // Orphans the current storage and allocates regions of `regionSize` bytes each.
+    void allocate(std::size_t regionSize);
+
+    // Releases the storage, it's allocated again on the next map().
+    void release();
+
+    // Moves on to the next region, waiting for the GPU to finish reading from it if needed. Called once per frame.
+    void nextRegion();
+
+    // Maps `size` bytes at the current write position of the current region, growing the storage if they don't fit.
+    // The buffer is left bound. Returns nullptr on failure.
+    std::byte *map(std::size_t size);
+    void unmap();
+
+    // Offset of the last mapped range in the buffer.
+    std::size_t mappedOffset() const { return m_mappedOffset; }
+
+    // Guards the current region with a fence. Called after the draw calls that read from it.
+    void fence();
+
+    std::size_t regionSize() const { return m_regionSize; }
+    std::size_t regionCount() const { return m_fences.size(); }
+
+    const Buffer &buffer() const { return m_buffer; }
+
+private:
+    void deleteFences();
+
+    Buffer m_buffer;
+    std::vector<GLsync> m_fences;
+    std::size_t m_regionSize{0};
+    std::size_t m_region{0};
+    std::size_t m_writeOffset{0}; // relative to the start of the current region
+    std::size_t m_mappedOffset{0};
+};
+
+} // namespace muui::gl
@@ -1,9 +1,15 @@
 #include "screen.h"
 
+#include "framebuffer.h"
+#include "framedamage.h"
 #include "item.h"
 #include "painter.h"
+#include "system.h"
 
 #include "gl.h"
+#include "statecache.h"
+
+#include <cmath>
 
 namespace muui
 {
@@ -13,40 +19,140 @@ Screen::Screen()
     resizedSignal.connect([this](Size size) { m_painter->setWindowSize(size.width, size.height); });
 }
 
-Screen::~Screen() = default;
+Screen::~Screen()
+{
+    // the items outlive the registry
+    setNameRegistry(nullptr);
+}
+
+void Screen::setNameRegistryEnabled(bool enabled)
+{
+    if (enabled == nameRegistryEnabled())
+        return;
+    if (enabled)
+    {
+        m_nameRegistry = std::make_unique<NameRegistry>();
+        setNameRegistry(m_nameRegistry.get());
+    }
+    else
+    {
+        setNameRegistry(nullptr);
+        m_nameRegistry.reset();
+    }
+}
+
+void Screen::setRetainedRendering(bool enabled)
+{
+    if (enabled == m_painter->retainedRendering())
+        return;
+    m_painter->setRetainedRendering(enabled);
+    invalidate();
+}
+
+bool Screen::retainedRendering() const
+{
+    return m_painter->retainedRendering();
+}
+
+void Screen::setPartialUpdatesEnabled(bool enabled)
+{
+    if (enabled == m_partialUpdates)
+        return;
+    m_partialUpdates = enabled;
+    m_framebuffer.reset();
+    invalidate();
+}
 
 void Screen::render()
 {
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
+    layout();
+
+    auto &stateCache = gl::stateCache();
+    stateCache.setEnabled(GL_CULL_FACE, false);
+    stateCache.setEnabled(GL_DEPTH_TEST, false);
+    stateCache.setEnabled(GL_BLEND, true);
+
+    if (m_partialUpdates)
+    {
+        const auto damage = updateDamage();
+        if (damage)
+            renderDamage(*damage);
+        sys::frameDamage()->add(damage);
+        stateCache.setEnabled(GL_BLEND, false);
+        m_framebuffer->blit();
+        return;
+    }
+
+    // nothing was invalidated since the last frame, draw it again as it is
+    const bool resubmitted = retainedRendering() && !isInvalidated() && m_painter->resubmitFrame();
+    if (!resubmitted)
+    {
+        m_painter->begin();
+        Rectangle::render(m_painter.get());
+        m_painter->end();
+    }
+    sys::frameDamage()->addFull();
+
+    stateCache.setEnabled(GL_BLEND, false);
+}
+
+std::optional<RectF> Screen::updateDamage()
+{
+    const auto width = static_cast<int>(m_size.width);
+    const auto height = static_cast<int>(m_size.height);
+    if (!m_framebuffer || m_framebuffer->width() != width || m_framebuffer->height() != height)
+    {
+        // the previous contents are gone, everything needs to be drawn again
+        m_framebuffer = std::make_unique<gl::Framebuffer>(width, height);
+        invalidate();
+    }
 
+    std::optional<RectF> damage;
+    updateBounds(Transform{}, damage);
+    if (!damage)
+        return {};
+    // whole pixels, so that the scissor covers all of the partially covered ones
+    const auto window = RectF{glm::vec2{0.0f}, glm::vec2{width, height}};
+    auto rect = *damage & window;
+    rect.min = glm::floor(rect.min);
+    rect.max = glm::ceil(rect.max);
+    if (rect.width() <= 0.0f || rect.height() <= 0.0f)
+        return {};
+    return rect;
+}
+
+void Screen::renderDamage(const RectF &damage)
+{
+    auto &stateCache = gl::stateCache();
+    gl::FramebufferBinder binder(*m_framebuffer);
+
+    // GL puts the origin in the bottom left corner
+    const auto x = static_cast<GLint>(damage.min.x);
+    const auto y = static_cast<GLint>(m_framebuffer->height() - damage.max.y);
+    stateCache.setEnabled(GL_SCISSOR_TEST, true);
+    glScissor(x, y, static_cast<GLsizei>(damage.width()), static_cast<GLsizei>(damage.height()));
+    // with the clear color set by the application
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    m_painter->setDamageRect(damage);
     m_painter->begin();
     Rectangle::render(m_painter.get());
     m_painter->end();
+    m_painter->setDamageRect(std::nullopt);
 
-    glDisable(GL_BLEND);
+    stateCache.setEnabled(GL_SCISSOR_TEST, false);
 }
 
 bool Screen::handleTouchEvent(TouchAction action, int x, int y)
 {
+    layout();
+
     const auto pos = glm::vec2(x, y);
     switch (action)
     {
     case TouchAction::Down: {
         assert(!m_clickTarget);
-        for (auto &layoutItem : m_layoutItems)
-        {
-            auto *item = layoutItem.item();
-            const auto size = item->size();
-            const auto rect = RectF{layoutItem.offset, layoutItem.offset + glm::vec2{size.width, size.height}};
-            if (rect.contains(pos))
-            {
-                m_clickTarget = item->mouseEvent({TouchEvent::Type::Press, pos - layoutItem.offset});
-                if (m_clickTarget)
-                    break;
-            }
-        }
+        m_clickTarget = mouseEvent({TouchEvent::Type::Press, pos});
         assert(!m_grabTarget);
         m_grabTarget = nullptr;
         m_dragStarted = false;
@@ -55,16 +161,7 @@ bool Screen::handleTouchEvent(TouchAction action, int x, int y)
     }
     case TouchAction::Up: {
         bool clicked = false;
-        for (auto &layoutItem : m_layoutItems)
-        {
-            auto *item = layoutItem.item();
-            const auto size = item->size();
-            const auto rect = RectF{layoutItem.offset, layoutItem.offset + glm::vec2{size.width, size.height}};
-            if (rect.contains(pos))
-            {
-                item->mouseEvent({TouchEvent::Type::Release, pos - layoutItem.offset});
-            }
-        }
+        mouseEvent({TouchEvent::Type::Release, pos});
         if (m_clickTarget)
         {
             m_clickTarget->mouseEvent({TouchEvent::Type::Click, {}});
@@ -84,19 +181,7 @@ bool Screen::handleTouchEvent(TouchAction action, int x, int y)
         if (!m_dragStarted && glm::distance(pos, m_lastTouchPosition) > StartDragDistance)
         {
             assert(!m_grabTarget);
-            for (auto &layoutItem : m_layoutItems)
-            {
-                auto *item = layoutItem.item();
-                const auto size = item->size();
-                const auto rect = RectF{layoutItem.offset, layoutItem.offset + glm::vec2{size.width, size.height}};
-                if (rect.contains(pos))
-                {
-                    m_grabTarget =
-                        item->mouseEvent({TouchEvent::Type::DragBegin, m_lastTouchPosition - layoutItem.offset});
-                    if (m_grabTarget)
-                        break;
-                }
-            }
+            m_grabTarget = mouseEvent({TouchEvent::Type::DragBegin, m_lastTouchPosition});
             m_clickTarget = nullptr;
             m_dragStarted = true;
         }
@@ -12,12 +12,31 @@ namespace muui
 class Item;
 class Painter;
 
+namespace gl
+{
+class Framebuffer;
+}
+
 class Screen : public Rectangle
 {
 public:
     Screen();
     ~Screen();
 
+    // Items record what they draw and only changed subtrees are drawn again, see Item::invalidate()
+    void setRetainedRendering(bool enabled);
+    bool retainedRendering() const;
+
+    // The screen is kept in an offscreen framebuffer, and only the area covered by items that changed since the last
+    // frame is drawn again, see Item::invalidate()
+    void setPartialUpdatesEnabled(bool enabled);
+    bool partialUpdatesEnabled() const { return m_partialUpdates; }
+
+    // Items are indexed by objectName as they're added, removed or renamed, so that findChild() doesn't have to walk
+    // the tree
+    void setNameRegistryEnabled(bool enabled);
+    bool nameRegistryEnabled() const { return m_nameRegistry != nullptr; }
+
     void render();
     bool handleTouchEvent(TouchAction type, int x, int y);
 
@@ -27,6 +46,14 @@ public:
     Item *m_clickTarget = nullptr;
     bool m_dragStarted = false;
     glm::vec2 m_lastTouchPosition;
+
+private:
+    std::optional<RectF> updateDamage();
+    void renderDamage(const RectF &damage);
+
+    bool m_partialUpdates = false;
+    std::unique_ptr<gl::Framebuffer> m_framebuffer;
+    std::unique_ptr<NameRegistry> m_nameRegistry;
 };
 
 } // namespace muui
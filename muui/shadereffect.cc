@@ -51,13 +51,9 @@ void ShaderEffect::render(Painter *painter, int depth)
     {
         gl::FramebufferBinder binder(*m_framebuffer);
 
-        glDisable(GL_BLEND);
-
         glClearColor(0, 0, 0, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glEnable(GL_BLEND);
-
         m_painter.begin();
         m_painter.translate({m_padding, m_padding});
         m_source->doRender(&m_painter, 0);
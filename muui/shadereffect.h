@@ -30,6 +30,7 @@ public:
 
     int width() const { return m_painter.windowWidth(); }
     int height() const { return m_painter.windowHeight(); }
+    int padding() const { return m_padding; }
 
 protected:
     virtual void applyEffect(Painter *painter, int depth) = 0;
@@ -5,6 +5,7 @@
 #include <fmt/core.h>
 
 #include <span>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -13,8 +14,17 @@ namespace muui
 
 namespace
 {
-std::unique_ptr<gl::ShaderProgram> loadProgram(const ProgramDescription &description)
+std::unique_ptr<gl::ShaderProgram> loadProgram(const ProgramDescription &description, ProgramVariants variants = {})
 {
+    auto defines = description.defines;
+    if (variants.testFlag(ProgramVariant::Instanced))
+        defines.push_back({"INSTANCED", "1"});
+    if (variants.testFlag(ProgramVariant::MultiTexture))
+    {
+        defines.push_back({"MULTI_TEXTURE", "1"});
+        defines.push_back({"MAX_BATCH_TEXTURES", std::to_string(MaxBatchTextures)});
+    }
+
     auto program = std::make_unique<gl::ShaderProgram>();
     auto addShader = [program = program.get()](gl::Shader::Type type, const std::filesystem::path &path,
                                                const std::span<const ProgramDescription::Define> defines) {
@@ -39,11 +49,11 @@ std::unique_ptr<gl::ShaderProgram> loadProgram(const ProgramDescription &descrip
         program->attach(std::move(shader));
         return true;
     };
-    if (!addShader(gl::Shader::Type::Vertex, description.vertexShaderPath, description.defines))
+    if (!addShader(gl::Shader::Type::Vertex, description.vertexShaderPath, defines))
     {
         return {};
     }
-    if (!addShader(gl::Shader::Type::Fragment, description.fragmentShaderPath, description.defines))
+    if (!addShader(gl::Shader::Type::Fragment, description.fragmentShaderPath, defines))
     {
         return {};
     }
@@ -59,6 +69,12 @@ std::unique_ptr<gl::ShaderProgram> loadProgram(const ProgramDescription &descrip
 
 ShaderManager::ShaderManager()
 {
+    static const char *uniformNames[] = {"mvp", "baseColorTexture", "baseColorTextures", "gradientTexture",
+                                         "horizontal"};
+    static_assert(std::extent_v<decltype(uniformNames)> == static_cast<int>(UniformId::NumDefaultUniforms));
+    for (const auto *name : uniformNames)
+        uniformId(name);
+
     addBasicPrograms();
 }
 
@@ -71,12 +87,14 @@ ShaderManager::ProgramHandle ShaderManager::addProgram(const ProgramDescription
         return ProgramHandle::Invalid;
     auto cachedProgram = std::make_unique<CachedProgram>();
     cachedProgram->description = description;
-    cachedProgram->program = std::move(program);
+    auto &compiledProgram = cachedProgram->variants[0];
+    compiledProgram = std::make_unique<CompiledProgram>();
+    compiledProgram->program = std::move(program);
     m_cachedPrograms.push_back(std::move(cachedProgram));
     return ProgramHandle{static_cast<int>(m_cachedPrograms.size()) - 1};
 }
 
-void ShaderManager::useProgram(ProgramHandle handle)
+void ShaderManager::useProgram(ProgramHandle handle, ProgramVariants variants)
 {
     if (handle == ProgramHandle::Invalid) {
         m_currentProgram = nullptr;
@@ -85,25 +103,55 @@ void ShaderManager::useProgram(ProgramHandle handle)
     const auto index = static_cast<int>(handle);
     assert(index >= 0 && index < m_cachedPrograms.size());
     auto &cachedProgram = m_cachedPrograms[index];
-    if (cachedProgram.get() == m_currentProgram)
+    assert((cachedProgram->description.variants & variants) == variants);
+    auto &compiledProgram = cachedProgram->variants[static_cast<unsigned>(variants)];
+    if (!compiledProgram)
+    {
+        compiledProgram = std::make_unique<CompiledProgram>();
+        compiledProgram->program = loadProgram(cachedProgram->description, variants);
+    }
+    if (compiledProgram.get() == m_currentProgram)
         return;
-    if (cachedProgram->program)
-        cachedProgram->program->bind();
-    m_currentProgram = cachedProgram.get();
+    if (compiledProgram->program)
+        compiledProgram->program->bind();
+    m_currentProgram = compiledProgram.get();
+}
+
+bool ShaderManager::supportsVariants(ProgramHandle handle, ProgramVariants variants) const
+{
+    if (handle == ProgramHandle::Invalid)
+        return false;
+    const auto index = static_cast<int>(handle);
+    assert(index >= 0 && index < m_cachedPrograms.size());
+    return (m_cachedPrograms[index]->description.variants & variants) == variants;
+}
+
+ShaderManager::UniformId ShaderManager::uniformId(std::string_view name)
+{
+    if (auto it = m_uniformIds.find(name); it != m_uniformIds.end())
+        return it->second;
+    const auto id = static_cast<UniformId>(m_uniformNames.size());
+    m_uniformNames.emplace_back(name);
+    m_uniformIds.emplace(name, id);
+    return id;
 }
 
-int ShaderManager::uniformLocation(const std::string &uniform)
+ShaderManager::Uniform *ShaderManager::currentUniform(UniformId id)
 {
-    if (!m_currentProgram || !m_currentProgram->program)
-        return -1;
-    auto &uniformLocations = m_currentProgram->uniformLocations;
-    auto it = uniformLocations.find(uniform);
-    if (it == uniformLocations.end())
+    if (!m_currentProgram || !m_currentProgram->program || id == UniformId::Invalid)
+        return nullptr;
+    const auto index = static_cast<std::size_t>(id);
+    assert(index < m_uniformNames.size());
+    auto &uniforms = m_currentProgram->uniforms;
+    if (index >= uniforms.size())
+        uniforms.resize(m_uniformNames.size());
+    auto &uniform = uniforms[index];
+    if (!uniform.resolved)
     {
-        auto location = m_currentProgram->program->uniformLocation(uniform.c_str());
-        it = uniformLocations.emplace(uniform, location).first;
+        uniform.location = m_currentProgram->program->uniformLocation(m_uniformNames[index].c_str());
+        uniform.resolved = true;
     }
-    return it->second;
+    return uniform.location != -1 ? &uniform : nullptr;
 }
 
 void ShaderManager::addBasicPrograms()
@@ -112,22 +160,31 @@ void ShaderManager::addBasicPrograms()
     {
         const char *vertexShader;
         const char *fragmentShader;
+        ProgramVariants variants;
     };
+    // sprite programs read their vertex attributes through sprite.inc.vert, and their base color through
+    // sprite.inc.frag if they're textured
+    constexpr auto SpriteVariants = ProgramVariant::Instanced;
+    const auto TexturedSpriteVariants = ProgramVariant::Instanced | ProgramVariant::MultiTexture;
     static const Program programSources[] = {
-        {"copy.vert", "copy.frag"},
-        {"flat.vert", "flat.frag"},
-        {"decal.vert", "decal.frag"},
-        {"circle.vert", "circle.frag"},
-        {"roundedrect.vert", "roundedrect.frag"},
-        {"text.vert", "text.frag"},
-        {"text.vert", "textoutline.frag"},
-        {"gradient.vert", "gradient.frag"},
-        {"decalgradient.vert", "decalgradient.frag"},
-        {"circlegradient.vert", "circlegradient.frag"},
-        {"roundedrectgradient.vert", "roundedrectgradient.frag"},
-        {"textgradient.vert", "textgradient.frag"},
-        {"textgradient.vert", "textgradientoutline.frag"},
-        {"gaussianblur.vert", "gaussianblur.frag"},
+        {"copy.vert", "copy.frag", TexturedSpriteVariants},
+        {"flat.vert", "flat.frag", SpriteVariants},
+        {"decal.vert", "decal.frag", TexturedSpriteVariants},
+        {"circle.vert", "circle.frag", SpriteVariants},
+        {"roundedrect.vert", "roundedrect.frag", SpriteVariants},
+        {"text.vert", "text.frag", TexturedSpriteVariants},
+        {"text.vert", "textoutline.frag", TexturedSpriteVariants},
+        {"gradient.vert", "gradient.frag", SpriteVariants},
+        {"decalgradient.vert", "decalgradient.frag", TexturedSpriteVariants},
+        {"circlegradient.vert", "circlegradient.frag", SpriteVariants},
+        {"roundedrectgradient.vert", "roundedrectgradient.frag", SpriteVariants},
+        {"textgradient.vert", "textgradient.frag", TexturedSpriteVariants},
+        {"textgradient.vert", "textgradientoutline.frag", TexturedSpriteVariants},
+        {"gaussianblur.vert", "gaussianblur.frag", {}},
+        {"textdistancefield.vert", "textdistancefield.frag", TexturedSpriteVariants},
+        {"textgradientdistancefield.vert", "textgradientdistancefield.frag", TexturedSpriteVariants},
+        {"textdistancefield.vert", "textmsdf.frag", TexturedSpriteVariants},
+        {"textgradientdistancefield.vert", "textgradientmsdf.frag", TexturedSpriteVariants},
     };
     static_assert(std::extent_v<decltype(programSources)> == static_cast<int>(ProgramHandle::NumDefaultPrograms));
 
@@ -138,8 +195,11 @@ void ShaderManager::addBasicPrograms()
         static const std::filesystem::path shaderRootPath{":/assets/shaders"};
         auto cachedProgram = std::make_unique<CachedProgram>();
         cachedProgram->description = {.vertexShaderPath = shaderRootPath / program.vertexShader,
-                                      .fragmentShaderPath = shaderRootPath / program.fragmentShader};
-        cachedProgram->program = loadProgram(cachedProgram->description);
+                                      .fragmentShaderPath = shaderRootPath / program.fragmentShader,
+                                      .variants = program.variants};
+        auto &compiledProgram = cachedProgram->variants[0];
+        compiledProgram = std::make_unique<CompiledProgram>();
+        compiledProgram->program = loadProgram(cachedProgram->description);
         m_cachedPrograms.push_back(std::move(cachedProgram));
     }
 }
@@ -1,9 +1,18 @@
 #pragma once
 
+#include "flags.h"
 #include "noncopyable.h"
 #include "shaderprogram.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 class Connection;
 
@@ -15,6 +24,18 @@ namespace gl
 class ShaderProgram;
 }
 
+// Alternative versions of a program, compiled on demand with extra defines
+enum class ProgramVariant : unsigned
+{
+    None = 0,
+    Instanced = 1 << 0,    // INSTANCED
+    MultiTexture = 1 << 1, // MULTI_TEXTURE, samples baseColorTextures[MaxBatchTextures]
+};
+MUUI_DEFINE_FLAGS(ProgramVariants, ProgramVariant)
+
+// Must match the number of cases in sprite.inc.frag
+constexpr int MaxBatchTextures = 8;
+
 struct ProgramDescription
 {
     struct Define
@@ -25,6 +46,7 @@ struct ProgramDescription
     std::vector<Define> defines;
     std::filesystem::path vertexShaderPath;
     std::filesystem::path fragmentShaderPath;
+    ProgramVariants variants; // supported variants
 };
 
 class ShaderManager : private NonCopyable
@@ -51,24 +73,56 @@ public:
         TextGradient,
         TextGradientOutline,
         GaussianBlur,
+        TextDistanceField,
+        TextGradientDistanceField,
+        TextMsdf,
+        TextGradientMsdf,
 
         NumDefaultPrograms,
     };
 
+    // Uniforms are referred to by ids that are valid for every program, so that setting them doesn't involve any
+    // string lookups. Ids for other names are registered with uniformId(), preferably once at startup.
+    enum class UniformId : int
+    {
+        Invalid = -1,
+
+        Mvp = 0,
+        BaseColorTexture,
+        BaseColorTextures,
+        GradientTexture,
+        Horizontal,
+
+        NumDefaultUniforms,
+    };
+
     ProgramHandle addProgram(const ProgramDescription &description);
 
-    void useProgram(ProgramHandle handle);
+    void useProgram(ProgramHandle handle, ProgramVariants variants = {});
 
+    bool supportsVariants(ProgramHandle handle, ProgramVariants variants) const;
+
+    UniformId uniformId(std::string_view name);
+
+    // The last value set in each program is kept around, setting the same value again is a no-op.
     template<typename T>
-    void setUniform(const std::string &uniform, T &&value)
+    void setUniform(UniformId id, const T &value)
     {
-        if (!m_currentProgram)
+        auto *uniform = currentUniform(id);
+        if (!uniform)
             return;
-        const auto location = uniformLocation(uniform);
-        if (location == -1)
+        const auto bytes = uniformBytes(value);
+        if (uniform->valueSet && std::ranges::equal(uniform->value, bytes))
             return;
-        if (m_currentProgram->program)
-            m_currentProgram->program->setUniform(location, std::forward<T>(value));
+        uniform->value.assign(bytes.begin(), bytes.end());
+        uniform->valueSet = true;
+        m_currentProgram->program->setUniform(uniform->location, value);
+    }
+
+    template<typename T>
+    void setUniform(std::string_view uniform, const T &value)
+    {
+        setUniform(uniformId(uniform), value);
     }
 
     const gl::ShaderProgram *currentProgram() const
@@ -78,16 +132,52 @@ public:
 
 private:
     void addBasicPrograms();
-    int uniformLocation(const std::string &uniform);
+
+    struct Uniform
+    {
+        bool resolved{false};
+        int location{-1};
+        bool valueSet{false};
+        std::vector<std::byte> value;
+    };
+
+    struct CompiledProgram
+    {
+        std::unique_ptr<gl::ShaderProgram> program;
+        std::vector<Uniform> uniforms; // indexed by UniformId, resolved on first use
+    };
+
+    Uniform *currentUniform(UniformId id);
+
+    template<typename T>
+    static std::span<const std::byte> uniformBytes(const T &value)
+    {
+        return std::as_bytes(std::span(&value, 1));
+    }
+
+    template<typename T>
+    static std::span<const std::byte> uniformBytes(const std::vector<T> &value)
+    {
+        return std::as_bytes(std::span(value));
+    }
 
     struct CachedProgram
     {
         ProgramDescription description;
-        std::unique_ptr<gl::ShaderProgram> program;
-        std::unordered_map<std::string, int> uniformLocations;
+        std::unordered_map<unsigned, std::unique_ptr<CompiledProgram>> variants;
     };
+
+    struct StringHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
     std::vector<std::unique_ptr<CachedProgram>> m_cachedPrograms;
-    CachedProgram *m_currentProgram = nullptr;
+    CompiledProgram *m_currentProgram = nullptr;
+    std::vector<std::string> m_uniformNames;
+    // looked up without building a string
+    std::unordered_map<std::string, UniformId, StringHash, std::equal_to<>> m_uniformIds;
 };
 
 } // namespace muui
@@ -1,6 +1,7 @@
 #include "shaderprogram.h"
 
 #include "file.h"
+#include "statecache.h"
 
 #include <fmt/format.h>
 
@@ -196,6 +197,7 @@ ShaderProgram::~ShaderProgram()
     {
         for (auto &shader : m_attachedShaders)
             glDetachShader(m_id, shader.id());
+        stateCache().deleteProgram(m_id);
         glDeleteProgram(m_id);
     }
 }
@@ -283,7 +285,7 @@ bool ShaderProgram::link()
 
 void ShaderProgram::bind() const
 {
-    glUseProgram(m_id);
+    stateCache().useProgram(m_id);
 }
 
 int ShaderProgram::uniformLocation(const char *name) const
@@ -326,6 +328,11 @@ void ShaderProgram::setUniform(int location, const glm::vec4 &value) const
     glUniform4fv(location, 1, glm::value_ptr(value));
 }
 
+void ShaderProgram::setUniform(int location, const std::vector<int> &value) const
+{
+    glUniform1iv(location, value.size(), value.data());
+}
+
 void ShaderProgram::setUniform(int location, const std::vector<float> &value) const
 {
     glUniform1fv(location, value.size(), value.data());
@@ -83,6 +83,7 @@ public:
     void setUniform(int location, const glm::vec3 &v) const;
     void setUniform(int location, const glm::vec4 &v) const;
 
+    void setUniform(int location, const std::vector<int> &v) const;
     void setUniform(int location, const std::vector<float> &v) const;
     void setUniform(int location, const std::vector<glm::vec2> &v) const;
     void setUniform(int location, const std::vector<glm::vec3> &v) const;
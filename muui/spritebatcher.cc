@@ -1,56 +1,109 @@
 #include "spritebatcher.h"
 #include "abstracttexture.h"
+#include "radixsort.h"
+#include "renderlist.h"
+#include "renderstats.h"
+#include "statecache.h"
 #include "system.h"
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/packing.hpp>
 
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
 #include <optional>
 #include <span>
 
 namespace muui
 {
 
+namespace
+{
+
+bool usesPackedVertices([[maybe_unused]] ShaderManager::ProgramHandle program)
+{
+#if defined(MUUI_PACKED_SPRITE_VERTICES)
+    // Only programs whose texture coordinates and colors are all in [0, 1]. Gradients and rounded rects store pixel
+    // coordinates in them, and we don't know what custom programs expect.
+    switch (program)
+    {
+    case ShaderManager::ProgramHandle::Copy:
+    case ShaderManager::ProgramHandle::Flat:
+    case ShaderManager::ProgramHandle::Decal:
+    case ShaderManager::ProgramHandle::Circle:
+    case ShaderManager::ProgramHandle::Text:
+    case ShaderManager::ProgramHandle::TextOutline:
+        return true;
+    default:
+        return false;
+    }
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
 SpriteBatcher::SpriteBatcher()
-    : m_vertexBuffer(gl::Buffer::Type::Vertex, gl::Buffer::Usage::DynamicDraw)
+    : m_vertexBuffer(gl::Buffer::Type::Vertex)
     , m_indexBuffer(gl::Buffer::Type::Index, gl::Buffer::Usage::StaticDraw)
+    , m_quadVertexBuffer(gl::Buffer::Type::Vertex, gl::Buffer::Usage::StaticDraw)
+    , m_quadIndexBuffer(gl::Buffer::Type::Index, gl::Buffer::Usage::StaticDraw)
 {
-    std::vector<uint32_t> indices(MaxQuadsPerBatch * 6);
-    for (std::size_t i = 0; i < MaxQuadsPerBatch; ++i)
     {
-        indices[i * 6 + 0] = i * 4 + 0;
-        indices[i * 6 + 1] = i * 4 + 1;
-        indices[i * 6 + 2] = i * 4 + 2;
+        gl::VertexArray::Binder binder(&m_vao);
+        m_vertexBuffer.bind();
+        m_indexBuffer.bind();
 
-        indices[i * 6 + 3] = i * 4 + 2;
-        indices[i * 6 + 4] = i * 4 + 3;
-        indices[i * 6 + 5] = i * 4 + 0;
+        // attribute pointers are set for each batch in drawBatches()
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glEnableVertexAttribArray(3);
     }
-    m_indexBuffer.bind();
-    m_indexBuffer.allocate(std::as_bytes(std::span<uint32_t>(indices)));
 
-    gl::VertexArray::Binder binder(&m_vao);
-    m_vertexBuffer.bind();
-    m_indexBuffer.bind();
+    {
+        gl::VertexArray::Binder binder(&m_instancedVao);
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), reinterpret_cast<GLvoid *>(0));
+        static const std::array<glm::vec2, 4> quadVertices{
+            glm::vec2{0, 0}, glm::vec2{1, 0}, glm::vec2{1, 1}, glm::vec2{0, 1}};
+        m_quadVertexBuffer.bind();
+        m_quadVertexBuffer.allocate(std::as_bytes(std::span(quadVertices)));
 
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
-                          reinterpret_cast<GLvoid *>(2 * sizeof(GLfloat)));
+        static const std::array<uint16_t, 6> quadIndices{0, 1, 2, 2, 3, 0};
+        m_quadIndexBuffer.bind();
+        m_quadIndexBuffer.allocate(std::as_bytes(std::span(quadIndices)));
 
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
-                          reinterpret_cast<GLvoid *>(4 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
 
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
-                          reinterpret_cast<GLvoid *>(8 * sizeof(GLfloat)));
+        // per-instance attribute pointers are set for each batch in drawBatches()
+        for (int i = 1; i <= 6; ++i)
+        {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+        glVertexAttribDivisor(DepthAttribute, 1);
+        glVertexAttribDivisor(TextureIndexAttribute, 1);
+    }
 }
 
 SpriteBatcher::~SpriteBatcher() = default;
 
+std::size_t SpriteBatcher::BatchStateHash::operator()(const BatchState &state) const
+{
+    std::size_t hash = std::hash<const AbstractTexture *>{}(state.texture);
+    const auto combine = [&hash](std::size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+    combine(std::hash<const AbstractTexture *>{}(state.gradientTexture));
+    combine(static_cast<std::size_t>(state.program));
+    combine((static_cast<std::size_t>(state.blendFunc.sourceFactor) << 16) |
+            static_cast<std::size_t>(state.blendFunc.destFactor));
+    combine((state.instanced ? 1 : 0) | (state.multiTexture ? 2 : 0));
+    return hash;
+}
+
 void SpriteBatcher::setMvp(const glm::mat4 &mvp)
 {
     m_mvp = mvp;
@@ -78,159 +131,937 @@ void SpriteBatcher::scale(const glm::vec2 &v)
 
 void SpriteBatcher::setBatchProgram(ShaderManager::ProgramHandle program)
 {
+    if (m_batchProgram == program)
+        return;
     m_batchProgram = program;
+    invalidateBatchState();
 }
 
 void SpriteBatcher::setBatchTexture(const AbstractTexture *texture)
 {
+    if (m_batchTexture == texture)
+        return;
     m_batchTexture = texture;
+    invalidateBatchState();
 }
 
 void SpriteBatcher::setBatchGradientTexture(const AbstractTexture *texture)
 {
+    if (m_batchGradientTexture == texture)
+        return;
     m_batchGradientTexture = texture;
+    invalidateBatchState();
 }
 
 void SpriteBatcher::setBatchBlendFunc(BlendFunc blendFunc)
 {
+    if (m_batchBlendFunc == blendFunc)
+        return;
     m_batchBlendFunc = blendFunc;
+    invalidateBatchState();
+}
+
+void SpriteBatcher::setBatchMergingEnabled(bool enabled)
+{
+    m_batchMergingEnabled = enabled;
+}
+
+void SpriteBatcher::setInstancingEnabled(bool enabled)
+{
+    if (m_instancingEnabled == enabled)
+        return;
+    m_instancingEnabled = enabled;
+    invalidateBatchState();
+}
+
+void SpriteBatcher::setDepthTestEnabled(bool enabled)
+{
+    m_depthTestEnabled = enabled;
+}
+
+void SpriteBatcher::setMultiTextureEnabled(bool enabled)
+{
+    if (m_multiTextureEnabled == enabled)
+        return;
+    m_multiTextureEnabled = enabled;
+    invalidateBatchState();
+}
+
+void SpriteBatcher::setFrameRetained(bool retained)
+{
+    m_frameRetained = retained;
+    m_retainedData.clear();
+    m_retainedBatches.clear();
+}
+
+void SpriteBatcher::setShrinkPolicy(ShrinkPolicy policy)
+{
+    m_shrinkPolicy = policy;
 }
 
 void SpriteBatcher::begin()
 {
-    m_quadCount = 0;
+    if (m_shrinkPolicy == ShrinkPolicy::HighWaterMark && ++m_framesSinceShrink >= ShrinkInterval)
+    {
+        m_sprites.shrink(m_highWaterMark);
+        m_instances.shrink(m_highWaterMark);
+        if (m_sortKeys.capacity() > m_highWaterMark)
+        {
+            m_sortKeys.clear();
+            m_sortKeys.shrink_to_fit();
+            m_sortScratch.clear();
+            m_sortScratch.shrink_to_fit();
+        }
+        if (m_vertexBuffer.regionSize() >
+            2 * std::max<std::size_t>(m_highWaterMark, MinBufferQuads) * 4 * sizeof(SpriteVertex))
+        {
+            // reallocated with the right size on the next flush
+            m_vertexBuffer.release();
+        }
+        if (m_indexQuadCapacity > 2 * std::max<std::size_t>(m_highWaterMark, MinBufferQuads))
+        {
+            // reallocated with the right size when needed
+            m_indexQuadCapacity = 0;
+        }
+        m_highWaterMark = 0;
+        m_framesSinceShrink = 0;
+    }
+
+    m_depthSequence = 0;
+    m_vertexBuffer.nextRegion();
+
+    m_retainedData.clear();
+    m_retainedBatches.clear();
+
+    m_sprites.clear();
+    m_instances.clear();
     m_transform.reset();
     m_batchProgram = ShaderManager::ProgramHandle::Invalid;
     m_batchTexture = nullptr;
     m_batchGradientTexture = nullptr;
     // assume shaders output premultiplied alpha by default
     m_batchBlendFunc = {BlendFunc::Factor::One, BlendFunc::Factor::OneMinusSourceAlpha};
+    m_batchStates.clear();
+    m_batchStateIds.clear();
+    invalidateBatchState();
+    m_mergedBatchCount = 0;
+}
+
+int SpriteBatcher::internBatchState(bool instanced)
+{
+    const bool multiTexture = multiTextureSupported(instanced);
+    return internBatchState({m_batchProgram, multiTexture ? nullptr : m_batchTexture, m_batchGradientTexture,
+                             m_batchBlendFunc, instanced, multiTexture});
+}
+
+int SpriteBatcher::internBatchState(const BatchState &state)
+{
+    if (auto it = m_batchStateIds.find(state); it != m_batchStateIds.end())
+        return it->second;
+    if (m_batchStates.size() > StateMask)
+    {
+        // ran out of ids, start over
+        flush();
+        m_batchStates.clear();
+        m_batchStateIds.clear();
+        invalidateBatchState();
+    }
+    const auto id = static_cast<int>(m_batchStates.size());
+    m_batchStates.push_back(state);
+    m_batchStateIds.emplace(state, id);
+    return id;
+}
+
+bool SpriteBatcher::instancingSupported() const
+{
+    return m_instancingEnabled && sys::shaderManager()->supportsVariants(m_batchProgram, ProgramVariant::Instanced);
+}
+
+bool SpriteBatcher::multiTextureSupported(bool instanced) const
+{
+    if (!m_multiTextureEnabled || !m_batchTexture)
+        return false;
+    const auto variants = instanced ? ProgramVariant::Instanced | ProgramVariant::MultiTexture
+                                    : ProgramVariants{ProgramVariant::MultiTexture};
+    return sys::shaderManager()->supportsVariants(m_batchProgram, variants);
 }
 
 void SpriteBatcher::flush()
 {
-    if (m_quadCount == 0)
+    if (m_sprites.empty() && m_instances.empty())
         return;
 
-    static std::array<const Sprite *, MaxQuadsPerBatch> sortedQuads;
-    const auto quadsEnd = m_sprites.begin() + m_quadCount;
-    std::transform(m_sprites.begin(), quadsEnd, sortedQuads.begin(), [](const Sprite &sprite) { return &sprite; });
-    const auto sortedQuadsEnd = sortedQuads.begin() + m_quadCount;
-    std::stable_sort(sortedQuads.begin(), sortedQuadsEnd, [](const Sprite *a, const Sprite *b) {
-        return std::tie(a->depth, a->texture, a->gradientTexture, a->program) <
-               std::tie(b->depth, b->texture, b->gradientTexture, b->program);
-    });
+    const auto spriteCount = m_sprites.size() + m_instances.size();
+    m_highWaterMark = std::max(m_highWaterMark, spriteCount);
 
-    m_vertexBuffer.bind();
-    gl::VertexArray::Binder binder(&m_vao);
+    m_sortKeys.clear();
+    m_sprites.forEach([this](const Sprite &sprite) { m_sortKeys.push_back(sprite.sortKey); });
+    m_instances.forEach([this](const InstancedSprite &sprite) { m_sortKeys.push_back(sprite.sortKey); });
+    radixSort(m_sortKeys, m_sortScratch);
 
-    const AbstractTexture *currentTexture = nullptr;
-    const AbstractTexture *currentGradientTexture = nullptr;
-    ShaderManager::ProgramHandle currentProgram = ShaderManager::ProgramHandle::Invalid;
-    std::optional<BlendFunc> currentBlendMode;
+    buildBatches();
+    if (m_depthTestEnabled)
+        assignDepthSequence();
+
+    auto *stats = sys::renderStats();
+    stats->quads += spriteCount;
+    ++stats->flushes;
+    stats->batches += m_batches.size();
+
+    // lay out the data for all the batches, then upload it with a single map
+    std::size_t dataSize = 0;
+    for (auto &batch : m_batches)
+    {
+        const auto &state = m_batchStates[batch.stateId];
+        batch.dataOffset = dataSize;
+        dataSize += batch.quadCount * quadDataSize(state);
+        batch.depthOffset.reset();
+        if (m_depthTestEnabled)
+        {
+            batch.depthOffset = dataSize;
+            dataSize += batch.quadCount * quadDepthSize(state);
+        }
+        batch.textureIndexOffset.reset();
+        if (state.multiTexture)
+        {
+            batch.textureIndexOffset = dataSize;
+            dataSize += batch.quadCount * quadTextureIndexSize(state);
+            // texture indices are bytes, keep the next batch aligned
+            dataSize = (dataSize + 3) & ~std::size_t(3);
+        }
+    }
 
-    auto batchStart = sortedQuads.begin();
-    while (batchStart != sortedQuadsEnd)
+    if (m_vertexBuffer.regionSize() == 0)
+        m_vertexBuffer.allocate(MinBufferQuads * 4 * sizeof(SpriteVertex));
+    auto *mappedData = m_vertexBuffer.map(dataSize);
+    if (!mappedData)
     {
-        const auto *batchTexture = (*batchStart)->texture;
-        const auto *batchGradientTexture = (*batchStart)->gradientTexture;
-        const auto batchProgram = (*batchStart)->program;
-        const auto blendFunc = (*batchStart)->blendFunc;
-        const auto batchEnd =
-            std::find_if(batchStart + 1, sortedQuadsEnd,
-                         [batchTexture, batchGradientTexture, batchProgram, blendFunc](const Sprite *sprite) {
-                             return sprite->texture != batchTexture ||
-                                    sprite->gradientTexture != batchGradientTexture ||
-                                    sprite->program != batchProgram || sprite->blendFunc != blendFunc;
-                         });
+        m_sprites.clear();
+        m_instances.clear();
+        return;
+    }
+    stats->bytesMapped += dataSize;
+    stats->bytesUploaded += dataSize;
 
-        const auto quadCount = batchEnd - batchStart;
+    // A retained frame is written to system memory first, reading back from the mapped buffer could be very slow.
+    const auto retainedOffset = m_retainedData.size();
+    if (m_frameRetained)
+        m_retainedData.resize(retainedOffset + dataSize);
+    auto *data = m_frameRetained ? m_retainedData.data() + retainedOffset : mappedData;
 
-        if (!m_bufferAllocated || (m_quadIndex + quadCount > MaxQuadsPerBatch))
+    m_drawBatches.clear();
+    for (const auto &batch : m_batches)
+    {
+        const auto &batchState = m_batchStates[batch.stateId];
+        const auto forEachSortKey = [this, &batch](auto &&visitor) {
+            for (auto runIndex = batch.firstRun; runIndex != -1; runIndex = m_batchRuns[runIndex].next)
+            {
+                const auto &run = m_batchRuns[runIndex];
+                for (auto i = run.begin; i != run.end; ++i)
+                    visitor(m_sortKeys[i]);
+            }
+        };
+        auto *batchData = data + batch.dataOffset;
+        if (batchState.instanced)
+        {
+            auto *instance = reinterpret_cast<SpriteInstance *>(batchData);
+            forEachSortKey(
+                [this, &instance](std::uint64_t sortKey) { *instance++ = m_instances[sortKey & OrderMask].instance; });
+        }
+        else if (usesPackedVertices(batchState.program))
         {
-            // orphan the old buffer and grab a new memory block
-            m_vertexBuffer.allocate(MaxQuadsPerBatch * 4 * sizeof(SpriteVertex));
-            m_quadIndex = 0;
-            m_bufferAllocated = true;
+            auto *vertex = reinterpret_cast<PackedSpriteVertex *>(batchData);
+            forEachSortKey([this, &vertex](std::uint64_t sortKey) {
+                for (const auto &v : m_sprites[sortKey & OrderMask].vertices)
+                    *vertex++ = {v.position, glm::packUnorm2x16(v.texCoord), glm::packUnorm4x8(v.fgColor)};
+            });
+        }
+        else
+        {
+            auto *vertex = reinterpret_cast<SpriteVertex *>(batchData);
+            forEachSortKey([this, &vertex](std::uint64_t sortKey) {
+                const auto &vertices = m_sprites[sortKey & OrderMask].vertices;
+                vertex = std::copy(vertices.begin(), vertices.end(), vertex);
+            });
+        }
+        if (batch.depthOffset)
+        {
+            auto *depth = reinterpret_cast<float *>(data + *batch.depthOffset);
+            const auto valuesPerQuad = quadDepthSize(batchState) / sizeof(float);
+            for (auto runIndex = batch.firstRun; runIndex != -1; runIndex = m_batchRuns[runIndex].next)
+            {
+                const auto &run = m_batchRuns[runIndex];
+                for (auto i = run.begin; i != run.end; ++i)
+                    depth = std::fill_n(depth, valuesPerQuad, depthValue(m_depthSequences[i]));
+            }
         }
 
-        auto *data = m_vertexBuffer.mapRange<GLfloat>(m_quadIndex * 4 * GLVertexSize, quadCount * 4 * GLVertexSize,
-                                                      gl::Buffer::Access::Write
-#if defined(__EMSCRIPTEN__)
-                                                          | gl::Buffer::Access::InvalidateRange
-#else
-                                                          | gl::Buffer::Access::Unsynchronized
-#endif
-        );
-        for (auto it = batchStart; it != batchEnd; ++it)
+        const auto drawBatch = [&batch, &batchState](std::size_t firstQuad) {
+            const auto offset = [firstQuad](std::optional<std::size_t> offset, std::size_t quadSize) {
+                return offset ? std::optional<std::size_t>(*offset + firstQuad * quadSize) : std::nullopt;
+            };
+            return DrawBatch{batchState,
+                             batch.opaque,
+                             batch.repeatedState,
+                             batch.quadCount - firstQuad,
+                             batch.dataOffset + firstQuad * quadDataSize(batchState),
+                             offset(batch.depthOffset, quadDepthSize(batchState)),
+                             offset(batch.textureIndexOffset, quadTextureIndexSize(batchState))};
+        };
+        m_drawBatches.push_back(drawBatch(0));
+        if (batch.textureIndexOffset)
+        {
+            // Assign texture slots in drawing order, starting a new draw call when they run out. The draws split
+            // from the same batch share its data.
+            auto *textureIndex = reinterpret_cast<std::uint8_t *>(data + *batch.textureIndexOffset);
+            const auto indicesPerQuad = quadTextureIndexSize(batchState);
+            std::size_t quadIndex = 0;
+            const AbstractTexture *lastTexture = nullptr;
+            int lastSlot = 0;
+            forEachSortKey([&](std::uint64_t sortKey) {
+                const auto index = sortKey & OrderMask;
+                const auto *texture = batchState.instanced ? m_instances[index].texture : m_sprites[index].texture;
+                if (texture != lastTexture || quadIndex == 0)
+                {
+                    auto *current = &m_drawBatches.back();
+                    const auto textures = std::span(current->textures.data(), current->textureCount);
+                    const auto it = std::find(textures.begin(), textures.end(), texture);
+                    if (it != textures.end())
+                    {
+                        lastSlot = it - textures.begin();
+                    }
+                    else
+                    {
+                        if (current->textureCount == MaxBatchTextures)
+                        {
+                            const auto firstQuad = batch.quadCount - current->quadCount + quadIndex;
+                            current->quadCount = quadIndex;
+                            m_drawBatches.push_back(drawBatch(firstQuad));
+                            current = &m_drawBatches.back();
+                            current->textureLimitSplit = true;
+                            quadIndex = 0;
+                        }
+                        lastSlot = current->textureCount++;
+                        current->textures[lastSlot] = texture;
+                    }
+                    lastTexture = texture;
+                }
+                textureIndex = std::fill_n(textureIndex, indicesPerQuad, static_cast<std::uint8_t>(lastSlot));
+                ++quadIndex;
+            });
+        }
+    }
+    if (m_frameRetained)
+    {
+        std::memcpy(mappedData, data, dataSize);
+        for (const auto &batch : m_drawBatches)
         {
-            auto *quadPtr = *it;
+            auto retainedBatch = batch;
+            retainedBatch.dataOffset += retainedOffset;
+            if (retainedBatch.depthOffset)
+                *retainedBatch.depthOffset += retainedOffset;
+            if (retainedBatch.textureIndexOffset)
+                *retainedBatch.textureIndexOffset += retainedOffset;
+            m_retainedBatches.push_back(retainedBatch);
+        }
+    }
+    m_vertexBuffer.unmap();
 
-            const auto emitVertex = [&data](const SpriteVertex &vertex) {
-                *data++ = vertex.position.x;
-                *data++ = vertex.position.y;
+    drawBatches(m_drawBatches, m_vertexBuffer.mappedOffset());
 
-                *data++ = vertex.texCoord.x;
-                *data++ = vertex.texCoord.y;
+    m_sprites.clear();
+    m_instances.clear();
+}
 
-                *data++ = vertex.fgColor.x;
-                *data++ = vertex.fgColor.y;
-                *data++ = vertex.fgColor.z;
-                *data++ = vertex.fgColor.w;
+bool SpriteBatcher::resubmitFrame()
+{
+    if (!m_frameRetained || m_retainedBatches.empty())
+        return false;
 
-                *data++ = vertex.bgColor.x;
-                *data++ = vertex.bgColor.y;
-                *data++ = vertex.bgColor.z;
-                *data++ = vertex.bgColor.w;
-            };
+    m_vertexBuffer.nextRegion();
+    auto *data = m_vertexBuffer.map(m_retainedData.size());
+    if (!data)
+        return false;
+    std::memcpy(data, m_retainedData.data(), m_retainedData.size());
+    m_vertexBuffer.unmap();
+
+    auto *stats = sys::renderStats();
+    stats->bytesMapped += m_retainedData.size();
+    stats->bytesUploaded += m_retainedData.size();
+
+    drawBatches(m_retainedBatches, m_vertexBuffer.mappedOffset());
+
+    return true;
+}
+
+void SpriteBatcher::drawBatches(std::span<const DrawBatch> batches, std::size_t baseOffset)
+{
+    // the attribute pointers set below source from the bound array buffer
+    m_vertexBuffer.bind();
+
+    std::array<const AbstractTexture *, MaxBatchTextures> currentTextures{};
+    const AbstractTexture *currentGradientTexture = nullptr;
+    ShaderManager::ProgramHandle currentProgram = ShaderManager::ProgramHandle::Invalid;
+    ProgramVariants currentVariants;
+    const gl::VertexArray *currentVao = nullptr;
+    std::optional<BlendFunc> currentBlendMode;
+    std::optional<bool> currentOpaque;
 
-            emitVertex(quadPtr->vertices[0]);
-            emitVertex(quadPtr->vertices[1]);
-            emitVertex(quadPtr->vertices[2]);
-            emitVertex(quadPtr->vertices[3]);
+    auto &stateCache = gl::stateCache();
+    const bool depthTested = !batches.empty() && batches.front().depthOffset;
+    if (depthTested)
+    {
+        stateCache.setEnabled(GL_DEPTH_TEST, true);
+        // depth values are unique within the frame, the sprite painted last wins
+        stateCache.setDepthFunc(GL_LESS);
+    }
+    else
+    {
+        glVertexAttrib1f(DepthAttribute, 0.0f);
+    }
+
+    auto *stats = sys::renderStats();
+    static_assert(GradientTextureUnit < gl::StateCache::ScratchTextureUnit);
+    // A batch's textures are all uploaded before any of them is bound, and bindings always go through the state cache,
+    // which knows what is actually bound. The local copies only feed the stats.
+    const auto uploadTexture = [](const AbstractTexture *texture) {
+        if (texture)
+            texture->upload();
+    };
+    const auto bindTexture = [&currentTextures, stats](const AbstractTexture *texture, int unit) {
+        if (!texture)
+            return;
+        texture->bind(unit);
+        if (currentTextures[unit] != texture)
+        {
+            currentTextures[unit] = texture;
+            ++stats->textureBinds;
         }
-        m_vertexBuffer.unmap();
+    };
+
+    for (std::size_t batchIndex = 0; batchIndex < batches.size(); ++batchIndex)
+    {
+        const auto &batch = batches[batchIndex];
+        const auto &batchState = batch.state;
+        const auto *batchGradientTexture = batchState.gradientTexture;
+        const auto batchProgram = batchState.program;
+        const auto blendFunc = batchState.blendFunc;
+        const auto quadCount = batch.quadCount;
+        const bool instanced = batchState.instanced;
 
-        if (currentTexture != batchTexture)
+        ++stats->drawCalls;
+        if (batchIndex > 0)
+            countBatchBreak(batch, batches[batchIndex - 1], stats);
+
+        if (batchState.multiTexture)
+        {
+            for (int i = 0; i < batch.textureCount; ++i)
+                uploadTexture(batch.textures[i]);
+        }
+        else
         {
-            currentTexture = batchTexture;
-            if (currentTexture)
-                currentTexture->bind(0);
+            uploadTexture(batchState.texture);
         }
+        uploadTexture(batchGradientTexture);
 
-        if (currentGradientTexture != batchGradientTexture)
+        if (batchState.multiTexture)
         {
-            currentGradientTexture = batchGradientTexture;
-            if (currentGradientTexture)
-                currentGradientTexture->bind(1);
+            for (int i = 0; i < batch.textureCount; ++i)
+                bindTexture(batch.textures[i], i);
+        }
+        else
+        {
+            bindTexture(batchState.texture, 0);
+        }
+
+        if (batchGradientTexture)
+        {
+            batchGradientTexture->bind(GradientTextureUnit);
+            if (currentGradientTexture != batchGradientTexture)
+                ++stats->textureBinds;
         }
+        currentGradientTexture = batchGradientTexture;
 
-        if (currentProgram != batchProgram)
+        auto batchVariants = instanced ? ProgramVariant::Instanced : ProgramVariants{};
+        if (batchState.multiTexture)
+            batchVariants |= ProgramVariant::MultiTexture;
+        if (currentProgram != batchProgram || currentVariants != batchVariants)
         {
             currentProgram = batchProgram;
+            currentVariants = batchVariants;
             auto *shaderManager = sys::shaderManager();
-            shaderManager->useProgram(batchProgram);
-            shaderManager->setUniform("mvp", m_mvp);
-            if (currentTexture)
-                shaderManager->setUniform("baseColorTexture", 0);
+            shaderManager->useProgram(batchProgram, batchVariants);
+            ++stats->programSwitches;
+            shaderManager->setUniform(ShaderManager::UniformId::Mvp, m_mvp);
+            if (batchState.multiTexture)
+            {
+                static const auto units = [] {
+                    std::vector<int> units(MaxBatchTextures);
+                    std::iota(units.begin(), units.end(), 0);
+                    return units;
+                }();
+                shaderManager->setUniform(ShaderManager::UniformId::BaseColorTextures, units);
+            }
+            else if (batchState.texture)
+            {
+                shaderManager->setUniform(ShaderManager::UniformId::BaseColorTexture, 0);
+            }
             if (currentGradientTexture)
-                shaderManager->setUniform("gradientTexture", 1);
+                shaderManager->setUniform(ShaderManager::UniformId::GradientTexture, GradientTextureUnit);
         }
 
         if (currentBlendMode != blendFunc)
         {
             currentBlendMode = blendFunc;
-            glBlendFunc(static_cast<GLenum>(blendFunc.sourceFactor), static_cast<GLenum>(blendFunc.destFactor));
+            stateCache.setBlendFunc(static_cast<GLenum>(blendFunc.sourceFactor),
+                                    static_cast<GLenum>(blendFunc.destFactor));
+            ++stats->blendChanges;
+        }
+
+        if (depthTested && currentOpaque != batch.opaque)
+        {
+            // opaque sprites write depth and don't need blending, translucent ones are only depth tested
+            currentOpaque = batch.opaque;
+            stateCache.setEnabled(GL_BLEND, !batch.opaque);
+            stateCache.setDepthMask(batch.opaque);
+            ++stats->blendChanges;
+        }
+
+        const auto *batchVao = instanced ? &m_instancedVao : &m_vao;
+        if (currentVao != batchVao)
+        {
+            currentVao = batchVao;
+            currentVao->bind();
+        }
+
+        const auto offset = baseOffset + batch.dataOffset;
+        const auto withBase = [baseOffset](std::optional<std::size_t> offset) {
+            return offset ? std::optional<std::size_t>(baseOffset + *offset) : std::nullopt;
+        };
+        setPerQuadLayout(withBase(batch.depthOffset), withBase(batch.textureIndexOffset));
+        if (instanced)
+        {
+            setInstanceLayout(offset);
+            glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr, quadCount);
+        }
+        else
+        {
+            ensureIndexCapacity(quadCount);
+            setVertexLayout(usesPackedVertices(batchProgram), offset);
+            glDrawElements(GL_TRIANGLES, 6 * quadCount, GL_UNSIGNED_INT, nullptr);
+        }
+    }
+
+    if (currentVao)
+        currentVao->unbind();
+
+    if (depthTested)
+    {
+        stateCache.setEnabled(GL_DEPTH_TEST, false);
+        stateCache.setDepthMask(true);
+        stateCache.setEnabled(GL_BLEND, true);
+    }
+
+    m_vertexBuffer.fence();
+}
+
+void SpriteBatcher::countBatchBreak(const DrawBatch &batch, const DrawBatch &previous, RenderStats *stats)
+{
+    const auto &state = batch.state;
+    const auto &previousState = previous.state;
+    if (batch.textureLimitSplit)
+        ++stats->textureLimitBreaks;
+    else if (batch.opaque != previous.opaque)
+        ++stats->passBreaks;
+    else if (batch.repeatedState)
+        ++stats->depthBreaks;
+    else if (state.program != previousState.program || state.instanced != previousState.instanced ||
+             state.multiTexture != previousState.multiTexture)
+        ++stats->programBreaks;
+    else if (state.blendFunc != previousState.blendFunc)
+        ++stats->blendFuncBreaks;
+    else if (state.texture != previousState.texture)
+        ++stats->textureBreaks;
+    else if (state.gradientTexture != previousState.gradientTexture)
+        ++stats->gradientTextureBreaks;
+}
+
+void SpriteBatcher::beginRecording(RenderList *list)
+{
+    list->clear();
+    if (!m_recordingLists.empty())
+    {
+        auto *parent = m_recordingLists.back();
+        parent->m_children.emplace_back(parent->m_commands.size(), list);
+    }
+    m_recordingLists.push_back(list);
+}
+
+void SpriteBatcher::endRecording()
+{
+    assert(!m_recordingLists.empty());
+    m_recordingLists.pop_back();
+}
+
+void SpriteBatcher::recordSprite(const std::array<SpriteVertex, 4> &verts, int stateId,
+                                 const AbstractTexture *texture, int depth)
+{
+    auto *list = m_recordingLists.back();
+    list->m_commands.push_back({m_batchStates[stateId], texture, depth, list->m_sprites.size()});
+    list->m_sprites.push_back(verts);
+}
+
+void SpriteBatcher::recordSpriteInstance(const SpriteInstance &instance, int stateId,
+                                         const AbstractTexture *texture, int depth)
+{
+    auto *list = m_recordingLists.back();
+    list->m_commands.push_back({m_batchStates[stateId], texture, depth, list->m_instances.size()});
+    list->m_instances.push_back(instance);
+}
+
+void SpriteBatcher::replay(const RenderList &list)
+{
+    // the list being recorded only keeps a reference to the replayed one
+    if (!m_recordingLists.empty())
+    {
+        auto *parent = m_recordingLists.back();
+        parent->m_children.emplace_back(parent->m_commands.size(), &list);
+    }
+    std::vector<RenderList *> recordingLists;
+    std::swap(recordingLists, m_recordingLists);
+    replayCommands(list);
+    std::swap(recordingLists, m_recordingLists);
+}
+
+void SpriteBatcher::replayCommands(const RenderList &list)
+{
+    auto child = list.m_children.begin();
+    int stateId = InvalidBatchState;
+    for (std::size_t i = 0; i <= list.m_commands.size(); ++i)
+    {
+        for (; child != list.m_children.end() && child->first == i; ++child)
+        {
+            replayCommands(*child->second);
+            stateId = InvalidBatchState;
+        }
+        if (i == list.m_commands.size())
+            break;
+
+        const auto &command = list.m_commands[i];
+        const bool instanced = command.state.instanced;
+        if ((instanced ? m_instances.size() : m_sprites.size()) == MaxQuadsPerBatch)
+            flush();
+        // the state ids may have been reset by a flush in internBatchState(), hence the comparison
+        if (stateId == InvalidBatchState || stateId >= static_cast<int>(m_batchStates.size()) ||
+            !(m_batchStates[stateId] == command.state))
+            stateId = internBatchState(command.state);
+        if (instanced)
+            appendSpriteInstance(list.m_instances[command.index], stateId, command.texture, command.depth);
+        else
+            appendSprite(list.m_sprites[command.index], stateId, command.texture, command.depth);
+    }
+}
+
+void SpriteBatcher::buildBatches()
+{
+    m_batches.clear();
+    m_batchRuns.clear();
+    m_stateBatched.assign(m_batchStates.size(), false);
+
+    const auto stateId = [](std::uint64_t sortKey) { return static_cast<int>((sortKey >> OrderBits) & StateMask); };
+    // opaque sprites never share a batch with translucent ones, they're drawn with different GL state
+    constexpr auto RunKeyMask = (std::uint64_t(1) << PassShift) | (StateMask << OrderBits);
+
+    const auto spriteBounds = [this](std::uint64_t sortKey) {
+        const auto index = sortKey & OrderMask;
+        std::array<glm::vec2, 4> positions;
+        if (m_batchStates[(sortKey >> OrderBits) & StateMask].instanced)
+        {
+            const auto &instance = m_instances[index].instance;
+            const glm::mat2 transform(glm::vec2(instance.transform.x, instance.transform.y),
+                                      glm::vec2(instance.transform.z, instance.transform.w));
+            const auto &rect = instance.rect;
+            positions = {transform * glm::vec2(rect.x, rect.y), transform * glm::vec2(rect.z, rect.y),
+                         transform * glm::vec2(rect.z, rect.w), transform * glm::vec2(rect.x, rect.w)};
+            for (auto &p : positions)
+                p += instance.translation;
+        }
+        else
+        {
+            const auto &vertices = m_sprites[index].vertices;
+            std::transform(vertices.begin(), vertices.end(), positions.begin(),
+                           [](const SpriteVertex &v) { return v.position; });
+        }
+        RectF bounds{positions[0], positions[0]};
+        for (std::size_t i = 1; i < positions.size(); ++i)
+        {
+            bounds.min = glm::min(bounds.min, positions[i]);
+            bounds.max = glm::max(bounds.max, positions[i]);
+        }
+        return bounds;
+    };
+
+    const auto keyCount = m_sortKeys.size();
+    std::size_t runStart = 0;
+    while (runStart != keyCount)
+    {
+        // a run is a sequence of sorted sprites with the same state
+        const auto runStateId = stateId(m_sortKeys[runStart]);
+        const auto runOpaque = isOpaqueKey(m_sortKeys[runStart]);
+        auto runEnd = runStart + 1;
+        while (runEnd != keyCount && (m_sortKeys[runEnd] & RunKeyMask) == (m_sortKeys[runStart] & RunKeyMask))
+            ++runEnd;
+
+        const auto runIndex = static_cast<int>(m_batchRuns.size());
+        m_batchRuns.push_back({runStart, runEnd, -1});
+
+        Batch *mergeTarget = nullptr;
+        RectF runBounds;
+        if (runOpaque)
+        {
+            // The depth test takes care of the order of opaque sprites. They come before the translucent ones, so
+            // all the batches before this one are opaque.
+            const auto lookbackEnd = m_batches.size() > MaxMergeLookback ? m_batches.size() - MaxMergeLookback : 0;
+            for (auto i = m_batches.size(); i > lookbackEnd; --i)
+            {
+                if (m_batches[i - 1].stateId == runStateId)
+                {
+                    mergeTarget = &m_batches[i - 1];
+                    break;
+                }
+            }
+        }
+        else if (m_batchMergingEnabled)
+        {
+            runBounds = spriteBounds(m_sortKeys[runStart]);
+            for (auto i = runStart + 1; i != runEnd; ++i)
+                runBounds |= spriteBounds(m_sortKeys[i]);
+
+            // The run can be appended to an earlier batch with the same state if none of the batches drawn in between
+            // overlap it, since moving it before them doesn't change the result.
+            const auto lookbackEnd = m_batches.size() > MaxMergeLookback ? m_batches.size() - MaxMergeLookback : 0;
+            for (auto i = m_batches.size(); i > lookbackEnd; --i)
+            {
+                auto &batch = m_batches[i - 1];
+                if (batch.opaque)
+                    break;
+                if (batch.stateId == runStateId)
+                {
+                    mergeTarget = &batch;
+                    break;
+                }
+                if (batch.bounds.intersects(runBounds))
+                    break;
+            }
         }
 
-        glDrawElements(GL_TRIANGLES, 6 * quadCount, GL_UNSIGNED_INT,
-                       reinterpret_cast<void *>(m_quadIndex * 6 * sizeof(uint32_t)));
+        if (mergeTarget)
+        {
+            m_batchRuns[mergeTarget->lastRun].next = runIndex;
+            mergeTarget->lastRun = runIndex;
+            mergeTarget->quadCount += runEnd - runStart;
+            mergeTarget->bounds |= runBounds;
+            ++m_mergedBatchCount;
+            ++sys::renderStats()->mergedBatches;
+        }
+        else
+        {
+            m_batches.push_back({.stateId = runStateId,
+                                 .opaque = runOpaque,
+                                 .bounds = runBounds,
+                                 .firstRun = runIndex,
+                                 .lastRun = runIndex,
+                                 .quadCount = runEnd - runStart,
+                                 .repeatedState = m_stateBatched[runStateId]});
+            m_stateBatched[runStateId] = true;
+        }
+
+        runStart = runEnd;
+    }
+}
+
+std::size_t SpriteBatcher::quadDataSize(const BatchState &state)
+{
+    if (state.instanced)
+        return sizeof(SpriteInstance);
+    return 4 * (usesPackedVertices(state.program) ? sizeof(PackedSpriteVertex) : sizeof(SpriteVertex));
+}
+
+std::size_t SpriteBatcher::quadDepthSize(const BatchState &state)
+{
+    // one value per instance or per vertex
+    return (state.instanced ? 1 : 4) * sizeof(float);
+}
+
+std::size_t SpriteBatcher::quadTextureIndexSize(const BatchState &state)
+{
+    // one byte per instance or per vertex
+    return state.instanced ? 1 : 4;
+}
+
+// Opaque sprites are drawn front to back, so the depth values follow the order the sprites would be painted in
+// instead: back to front by depth, then by state and submission order, like the translucent ones are drawn.
+void SpriteBatcher::assignDepthSequence()
+{
+    const auto keyCount = m_sortKeys.size();
+    m_depthSequences.resize(keyCount);
+
+    // The opaque keys come first, in groups of the same depth from front to back, each group in painting order.
+    // Walking the groups backwards gives all of them in painting order, which is merged with the translucent keys.
+    const auto opaqueEnd = static_cast<std::size_t>(
+        std::partition_point(m_sortKeys.begin(), m_sortKeys.end(), isOpaqueKey) - m_sortKeys.begin());
+    const auto depthOf = [this](std::size_t index) { return m_sortKeys[index] >> (StateBits + OrderBits); };
+    std::size_t groupBegin = opaqueEnd;
+    std::size_t groupEnd = opaqueEnd;
+    std::size_t opaque = opaqueEnd;
+    std::size_t translucent = opaqueEnd;
+    auto sequence = m_depthSequence;
+    while (true)
+    {
+        if (opaque == groupEnd && groupBegin != 0)
+        {
+            groupEnd = groupBegin;
+            while (groupBegin != 0 && depthOf(groupBegin - 1) == depthOf(groupEnd - 1))
+                --groupBegin;
+            opaque = groupBegin;
+        }
+        const bool opaqueLeft = opaque != groupEnd;
+        const bool translucentLeft = translucent != keyCount;
+        if (!opaqueLeft && !translucentLeft)
+            break;
+        if (opaqueLeft &&
+            (!translucentLeft || paintOrderKey(m_sortKeys[opaque]) < paintOrderKey(m_sortKeys[translucent])))
+        {
+            m_depthSequences[opaque++] = sequence++;
+        }
+        else
+        {
+            m_depthSequences[translucent++] = sequence++;
+        }
+    }
+    m_depthSequence = sequence;
+}
+
+// The sort key of a translucent sprite, which orders sprites the way they're painted
+std::uint64_t SpriteBatcher::paintOrderKey(std::uint64_t sortKey)
+{
+    if (!isOpaqueKey(sortKey))
+        return sortKey;
+    // the inverted biased depth of opaque sprites, DepthBias - 1 - depth, becomes depth + DepthBias
+    constexpr auto DepthMask = ((std::uint64_t(1) << DepthBits) - 1) << (StateBits + OrderBits);
+    return (sortKey ^ DepthMask) | (std::uint64_t(1) << PassShift);
+}
+
+float SpriteBatcher::depthValue(std::uint32_t sequence)
+{
+    // mapped to (-1, 1], the orthographic projection flips it so that later sprites are closer. Translucent sprites
+    // past the end of the range share the last value, they're tested against the opaque ones but don't write depth.
+    constexpr auto Scale = static_cast<float>(MaxDepthSequence / 2);
+    return static_cast<float>(std::min(sequence, MaxDepthSequence - 1) + 1) / Scale - 1.0f;
+}
 
-        m_quadIndex += quadCount;
-        batchStart = batchEnd;
+void SpriteBatcher::ensureIndexCapacity(std::size_t quadCount)
+{
+    // only needed by non-instanced batches, the index buffer binding is part of m_vao so it must be bound here
+    if (quadCount <= m_indexQuadCapacity)
+        return;
+
+    auto quadCapacity = std::max<std::size_t>(m_indexQuadCapacity, MinBufferQuads);
+    while (quadCapacity < quadCount)
+        quadCapacity *= 2;
+
+    std::vector<uint32_t> indices(quadCapacity * 6);
+    for (std::size_t i = 0; i < quadCapacity; ++i)
+    {
+        indices[i * 6 + 0] = i * 4 + 0;
+        indices[i * 6 + 1] = i * 4 + 1;
+        indices[i * 6 + 2] = i * 4 + 2;
+
+        indices[i * 6 + 3] = i * 4 + 2;
+        indices[i * 6 + 4] = i * 4 + 3;
+        indices[i * 6 + 5] = i * 4 + 0;
+    }
+    m_indexBuffer.bind();
+    m_indexBuffer.allocate(std::as_bytes(std::span<uint32_t>(indices)));
+    m_indexQuadCapacity = quadCapacity;
+    sys::renderStats()->bytesUploaded += indices.size() * sizeof(uint32_t);
+}
+
+void SpriteBatcher::setPerQuadLayout(std::optional<std::size_t> depthOffset,
+                                     std::optional<std::size_t> textureIndexOffset)
+{
+    // Stored after the vertex or instance data of each batch, with one value per vertex or per instance. The divisor
+    // is set up in m_instancedVao.
+    if (depthOffset)
+    {
+        glEnableVertexAttribArray(DepthAttribute);
+        glVertexAttribPointer(DepthAttribute, 1, GL_FLOAT, GL_FALSE, sizeof(float),
+                              reinterpret_cast<GLvoid *>(*depthOffset));
     }
+    else
+    {
+        glDisableVertexAttribArray(DepthAttribute);
+    }
+    if (textureIndexOffset)
+    {
+        glEnableVertexAttribArray(TextureIndexAttribute);
+        glVertexAttribPointer(TextureIndexAttribute, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(std::uint8_t),
+                              reinterpret_cast<GLvoid *>(*textureIndexOffset));
+    }
+    else
+    {
+        glDisableVertexAttribArray(TextureIndexAttribute);
+    }
+}
 
-    m_quadCount = 0;
+void SpriteBatcher::setVertexLayout(bool packed, std::size_t offset)
+{
+    // vertex data for the current batch starts at `offset` in the vertex buffer
+    const auto attribOffset = [offset](std::size_t attribOffset) {
+        return reinterpret_cast<GLvoid *>(offset + attribOffset);
+    };
+    if (packed)
+    {
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(PackedSpriteVertex),
+                              attribOffset(offsetof(PackedSpriteVertex, position)));
+        glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedSpriteVertex),
+                              attribOffset(offsetof(PackedSpriteVertex, texCoord)));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedSpriteVertex),
+                              attribOffset(offsetof(PackedSpriteVertex, color)));
+        glDisableVertexAttribArray(3);
+    }
+    else
+    {
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+                              attribOffset(offsetof(SpriteVertex, position)));
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+                              attribOffset(offsetof(SpriteVertex, texCoord)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+                              attribOffset(offsetof(SpriteVertex, fgColor)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+                              attribOffset(offsetof(SpriteVertex, bgColor)));
+    }
+}
+
+void SpriteBatcher::setInstanceLayout(std::size_t offset)
+{
+    // instance data for the current batch starts at `offset` in the vertex buffer, attribute 0 is the unit quad
+    const auto attribOffset = [offset](std::size_t attribOffset) {
+        return reinterpret_cast<GLvoid *>(offset + attribOffset);
+    };
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          attribOffset(offsetof(SpriteInstance, texRect)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          attribOffset(offsetof(SpriteInstance, fgColor)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          attribOffset(offsetof(SpriteInstance, bgColor)));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          attribOffset(offsetof(SpriteInstance, rect)));
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          attribOffset(offsetof(SpriteInstance, transform)));
+    glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          attribOffset(offsetof(SpriteInstance, translation)));
 }
 
 } // namespace muui
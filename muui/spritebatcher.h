@@ -1,20 +1,32 @@
 #pragma once
 
 #include "buffer.h"
+#include "chunkedarray.h"
 #include "noncopyable.h"
+#include "ringbuffer.h"
 #include "shadermanager.h"
 #include "transform.h"
+#include "util.h"
 #include "vertexarray.h"
 
 #include <glm/vec2.hpp>
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
 namespace muui
 {
 class AbstractTexture;
+class RenderList;
 struct PackedPixmap;
+struct RenderStats;
 
 // clang-format off
 template<typename VertexT>
@@ -57,6 +69,12 @@ struct BlendFunc
 class SpriteBatcher : private NonCopyable
 {
 public:
+    enum class ShrinkPolicy
+    {
+        Never,        // keep the largest storage ever used
+        HighWaterMark // periodically release the storage above the recent high-water mark
+    };
+
     SpriteBatcher();
     ~SpriteBatcher();
 
@@ -82,9 +100,53 @@ public:
     void setBatchBlendFunc(BlendFunc blendFunc);
     BlendFunc batchBlendFunc() const { return m_batchBlendFunc; }
 
+    // When enabled, sprites are merged into an earlier batch with the same state if they don't overlap anything drawn
+    // in between, even if they were submitted with a different depth.
+    void setBatchMergingEnabled(bool enabled);
+    bool batchMergingEnabled() const { return m_batchMergingEnabled; }
+
+    // Number of batches merged into earlier ones since begin()
+    int mergedBatchCount() const { return m_mergedBatchCount; }
+
+    // When enabled, rects added with addSprite(topLeft, bottomRight, ...) are stored as a single instance each and
+    // drawn with instancing, as long as the batch program supports it.
+    void setInstancingEnabled(bool enabled);
+    bool instancingEnabled() const { return m_instancingEnabled; }
+
+    // When enabled, opaque sprites (currently solid colors with the Flat program) are drawn first, front to back with
+    // depth writes, and the rest of the sprites back to front with depth testing. Uses the depth buffer of the
+    // current framebuffer, which is expected to have 24 bits and to be cleared at the start of the frame.
+    void setDepthTestEnabled(bool enabled);
+    bool depthTestEnabled() const { return m_depthTestEnabled; }
+
+    // When enabled, sprites with different base color textures share a batch as long as the program supports it. Up
+    // to MaxBatchTextures textures are bound per draw call and selected in the shader with a per-vertex index.
+    void setMultiTextureEnabled(bool enabled);
+    bool multiTextureEnabled() const { return m_multiTextureEnabled; }
+
+    void setShrinkPolicy(ShrinkPolicy policy);
+    ShrinkPolicy shrinkPolicy() const { return m_shrinkPolicy; }
+
+    std::size_t spriteCapacity() const { return m_sprites.capacity() + m_instances.capacity(); }
+
     void begin();
     void flush();
 
+    // Sprites added between beginRecording() and endRecording() are also stored in `list`. Recordings can be nested,
+    // in which case the outer list keeps a reference to the inner one.
+    void beginRecording(RenderList *list);
+    void endRecording();
+    bool isRecording() const { return !m_recordingLists.empty(); }
+
+    // Adds the sprites stored in `list`, with the state and depth they were recorded with.
+    void replay(const RenderList &list);
+
+    // When enabled, the sorted data and batches of each frame are kept around so that resubmitFrame() can draw the
+    // same frame again without going through begin()/flush().
+    void setFrameRetained(bool retained);
+    bool frameRetained() const { return m_frameRetained; }
+    bool resubmitFrame();
+
     template<typename VertexT>
         requires HasPosition<VertexT>
     void addSprite(const std::array<VertexT, 4> &verts, int depth)
@@ -116,14 +178,14 @@ public:
         requires HasPosition<VertexT>
     void addSprite(const VertexT &topLeft, const VertexT &bottomRight, int depth)
     {
-        addSprite(unpack(topLeft, bottomRight), depth);
+        addRectSprite(topLeft, bottomRight, {}, {}, depth);
     }
 
     template<typename VertexT>
         requires HasPosition<VertexT>
     void addSprite(const VertexT &topLeft, const VertexT &bottomRight, const glm::vec4 &color, int depth)
     {
-        addSprite(unpack(topLeft, bottomRight, color), depth);
+        addRectSprite(topLeft, bottomRight, color, {}, depth);
     }
 
     template<typename VertexT>
@@ -131,7 +193,7 @@ public:
     void addSprite(const VertexT &topLeft, const VertexT &bottomRight, const glm::vec4 &fgColor,
                    const glm::vec4 &bgColor, int depth)
     {
-        addSprite(unpack(topLeft, bottomRight, fgColor, bgColor), depth);
+        addRectSprite(topLeft, bottomRight, fgColor, bgColor, depth);
     }
 
 private:
@@ -183,14 +245,106 @@ private:
         }
     };
 
-    struct Sprite
+    // Everything that forces a new draw call when it changes.
+    struct BatchState
     {
         ShaderManager::ProgramHandle program;
         const AbstractTexture *texture;
         const AbstractTexture *gradientTexture;
-        std::array<SpriteVertex, 4> vertices;
-        int depth;
         BlendFunc blendFunc;
+        bool instanced;
+        bool multiTexture; // texture is null, each sprite has its own
+        bool operator==(const BatchState &) const = default;
+    };
+
+    struct BatchStateHash
+    {
+        std::size_t operator()(const BatchState &state) const;
+    };
+
+    // Sort key layout, from most to least significant bits: pass | depth | batch state id | submission order
+    // Opaque sprites come first and have their depth inverted so that they're drawn front to back.
+    static constexpr int OrderBits = 19;
+    static constexpr int StateBits = 21;
+    static constexpr int PassBits = 1;
+    static constexpr int DepthBits = 64 - PassBits - StateBits - OrderBits;
+    static constexpr std::uint64_t OrderMask = (std::uint64_t(1) << OrderBits) - 1;
+    static constexpr std::uint64_t StateMask = (std::uint64_t(1) << StateBits) - 1;
+    static constexpr int DepthBias = 1 << (DepthBits - 1);
+    static constexpr int PassShift = 64 - PassBits;
+
+    static bool isOpaqueKey(std::uint64_t sortKey) { return (sortKey >> PassShift) == 0; }
+
+    // Compact vertex format for programs that only need normalized texture coordinates and colors.
+    struct PackedSpriteVertex
+    {
+        glm::vec2 position;
+        std::uint32_t texCoord; // unorm16 x 2
+        std::uint32_t color;    // unorm8 x 4
+    };
+    static_assert(sizeof(PackedSpriteVertex) == 16);
+
+    struct Sprite
+    {
+        std::array<SpriteVertex, 4> vertices;
+        const AbstractTexture *texture; // only used by multi-texture batches
+        std::uint64_t sortKey;
+    };
+
+    // Per-instance data for the instanced path, expanded to a unit quad in sprite.inc.vert
+    struct SpriteInstance
+    {
+        glm::vec4 transform; // 2x2 linear part, column-major
+        glm::vec2 translation;
+        glm::vec4 rect;    // top left, bottom right before the transform
+        glm::vec4 texRect; // top left, bottom right
+        glm::vec4 fgColor;
+        glm::vec4 bgColor;
+    };
+
+    struct InstancedSprite
+    {
+        SpriteInstance instance;
+        const AbstractTexture *texture; // only used by multi-texture batches
+        std::uint64_t sortKey;
+    };
+
+    // Range of sorted sprites, linked to the next range drawn in the same batch
+    struct BatchRun
+    {
+        std::size_t begin;
+        std::size_t end;
+        int next;
+    };
+
+    struct Batch
+    {
+        int stateId;
+        bool opaque;
+        RectF bounds;
+        int firstRun;
+        int lastRun;
+        std::size_t quadCount;
+        bool repeatedState{false}; // an earlier batch of the same flush has the same state
+        // in bytes, relative to the start of the data uploaded by flush()
+        std::size_t dataOffset{0};
+        std::optional<std::size_t> depthOffset{};        // if depth tested
+        std::optional<std::size_t> textureIndexOffset{}; // if multi-texture
+    };
+
+    struct DrawBatch
+    {
+        BatchState state;
+        bool opaque;
+        bool repeatedState;
+        std::size_t quadCount;
+        // in bytes
+        std::size_t dataOffset;
+        std::optional<std::size_t> depthOffset;
+        std::optional<std::size_t> textureIndexOffset;
+        std::array<const AbstractTexture *, MaxBatchTextures> textures{}; // if multi-texture
+        int textureCount{0};
+        bool textureLimitSplit{false}; // split from the previous draw because it ran out of texture slots
     };
 
     template<typename VertexT>
@@ -221,36 +375,179 @@ private:
                 SpriteVertex{m_transform.map({p0.x, p1.y}), {t0.x, t1.y}, fgColor, bgColor}};
     }
 
+    static std::uint64_t sortKey(bool opaque, int depth, int stateId, std::size_t order)
+    {
+        assert(depth >= -DepthBias && depth < DepthBias);
+        const auto biasedDepth = opaque ? DepthBias - 1 - depth : depth + DepthBias;
+        return (static_cast<std::uint64_t>(opaque ? 0 : 1) << PassShift) |
+               (static_cast<std::uint64_t>(biasedDepth) << (StateBits + OrderBits)) |
+               (static_cast<std::uint64_t>(stateId) << OrderBits) | order;
+    }
+
+    // Opaque sprites can be drawn in any order with depth testing. Once the frame is about to run out of depth
+    // values, the sprites of the following flushes are drawn back to front with the translucent ones instead.
+    bool isOpaque(int stateId, float alpha) const
+    {
+        if (!m_depthTestEnabled || alpha < 1.0f || m_depthSequence + MaxFlushSprites > MaxDepthSequence)
+            return false;
+        const auto &state = m_batchStates[stateId];
+        return state.program == ShaderManager::ProgramHandle::Flat &&
+               state.blendFunc.destFactor == BlendFunc::Factor::OneMinusSourceAlpha;
+    }
+
     void addSprite(const std::array<SpriteVertex, 4> &verts, int depth)
     {
-        if (m_quadCount == MaxQuadsPerBatch)
+        if (m_sprites.size() == MaxQuadsPerBatch)
             flush();
 
-        auto &sprite = m_sprites[m_quadCount++];
-        sprite.texture = m_batchTexture;
-        sprite.gradientTexture = m_batchGradientTexture;
-        sprite.program = m_batchProgram;
-        sprite.depth = depth;
-        sprite.blendFunc = m_batchBlendFunc;
+        if (m_batchStateId == InvalidBatchState)
+            m_batchStateId = internBatchState(false);
+
+        appendSprite(verts, m_batchStateId, m_batchTexture, depth);
+    }
+
+    void appendSprite(const std::array<SpriteVertex, 4> &verts, int stateId, const AbstractTexture *texture,
+                      int depth)
+    {
+        const auto order = m_sprites.size();
+        auto &sprite = m_sprites.append();
         sprite.vertices = verts;
+        sprite.texture = texture;
+        const auto alpha =
+            std::min({verts[0].fgColor.a, verts[1].fgColor.a, verts[2].fgColor.a, verts[3].fgColor.a});
+        sprite.sortKey = sortKey(isOpaque(stateId, alpha), depth, stateId, order);
+        if (!m_recordingLists.empty())
+            recordSprite(verts, stateId, texture, depth);
     }
 
-    static constexpr int MaxQuadsPerBatch = 512 * 1024;
-    static constexpr int GLVertexSize = sizeof(SpriteVertex) / sizeof(GLfloat); // in floats
+    template<typename VertexT>
+        requires HasPosition<VertexT>
+    void addRectSprite(const VertexT &topLeft, const VertexT &bottomRight, const glm::vec4 &fgColor,
+                       const glm::vec4 &bgColor, int depth)
+    {
+        if (m_instancedBatchStateId == InvalidBatchState)
+            m_instancedBatchStateId = instancingSupported() ? internBatchState(true) : NoBatchState;
+        if (m_instancedBatchStateId == NoBatchState)
+        {
+            addSprite(unpack(topLeft, bottomRight, fgColor, bgColor), depth);
+            return;
+        }
+
+        glm::vec4 texRect(0.0f);
+        if constexpr (HasTexCoord<VertexT>)
+            texRect = {topLeft.texCoord.x, topLeft.texCoord.y, bottomRight.texCoord.x, bottomRight.texCoord.y};
+        addSpriteInstance({topLeft.position.x, topLeft.position.y, bottomRight.position.x, bottomRight.position.y},
+                          texRect, fgColor, bgColor, depth);
+    }
+
+    void addSpriteInstance(const glm::vec4 &rect, const glm::vec4 &texRect, const glm::vec4 &fgColor,
+                           const glm::vec4 &bgColor, int depth)
+    {
+        if (m_instances.size() == MaxQuadsPerBatch)
+            flush();
+
+        const auto matrix = m_transform.matrix();
+        appendSpriteInstance({{matrix[0].x, matrix[0].y, matrix[1].x, matrix[1].y},
+                              {matrix[2].x, matrix[2].y},
+                              rect,
+                              texRect,
+                              fgColor,
+                              bgColor},
+                             m_instancedBatchStateId, m_batchTexture, depth);
+    }
 
-    std::array<Sprite, MaxQuadsPerBatch> m_sprites;
-    int m_quadCount{0};
-    gl::Buffer m_vertexBuffer;
+    void appendSpriteInstance(const SpriteInstance &instance, int stateId, const AbstractTexture *texture, int depth)
+    {
+        const auto order = m_instances.size();
+        auto &sprite = m_instances.append();
+        sprite.instance = instance;
+        sprite.texture = texture;
+        sprite.sortKey = sortKey(isOpaque(stateId, instance.fgColor.a), depth, stateId, order);
+        if (!m_recordingLists.empty())
+            recordSpriteInstance(instance, stateId, texture, depth);
+    }
+
+    void recordSprite(const std::array<SpriteVertex, 4> &verts, int stateId, const AbstractTexture *texture,
+                      int depth);
+    void recordSpriteInstance(const SpriteInstance &instance, int stateId, const AbstractTexture *texture, int depth);
+    void replayCommands(const RenderList &list);
+
+    void invalidateBatchState() { m_batchStateId = m_instancedBatchStateId = InvalidBatchState; }
+    int internBatchState(bool instanced);
+    int internBatchState(const BatchState &state);
+    bool instancingSupported() const;
+    bool multiTextureSupported(bool instanced) const;
+
+    void buildBatches();
+    static std::size_t quadDataSize(const BatchState &state);
+    static std::size_t quadDepthSize(const BatchState &state);
+    static std::size_t quadTextureIndexSize(const BatchState &state);
+    void assignDepthSequence();
+    static std::uint64_t paintOrderKey(std::uint64_t sortKey);
+    static float depthValue(std::uint32_t sequence);
+    void drawBatches(std::span<const DrawBatch> batches, std::size_t baseOffset);
+    static void countBatchBreak(const DrawBatch &batch, const DrawBatch &previous, RenderStats *stats);
+    void setPerQuadLayout(std::optional<std::size_t> depthOffset, std::optional<std::size_t> textureIndexOffset);
+    void setVertexLayout(bool packed, std::size_t offset);
+    void setInstanceLayout(std::size_t offset);
+    void ensureIndexCapacity(std::size_t quadCount);
+
+    static constexpr int MaxQuadsPerBatch = 512 * 1024;
+    static_assert(MaxQuadsPerBatch <= OrderMask + 1);
+    static constexpr int MinBufferQuads = 1024;
+    static constexpr int SpriteChunkSize = 256;
+    static constexpr int ShrinkInterval = 120; // in frames
+    static constexpr std::size_t MaxMergeLookback = 64; // in batches
+    static constexpr std::size_t MaxFlushSprites = 2 * MaxQuadsPerBatch; // sprites and instances
+    static constexpr std::uint32_t MaxDepthSequence = 1 << 22; // distinct depth values per frame, for 24 bit buffers
+    static constexpr GLuint DepthAttribute = 7;
+    static constexpr GLuint TextureIndexAttribute = 8;
+    static constexpr int GradientTextureUnit = MaxBatchTextures; // base color textures use the units below
+
+    static constexpr int InvalidBatchState = -1;
+    static constexpr int NoBatchState = -2; // instancing not supported with the current state
+
+    ChunkedArray<Sprite, SpriteChunkSize> m_sprites;
+    ChunkedArray<InstancedSprite, SpriteChunkSize> m_instances;
+    std::vector<std::uint64_t> m_sortKeys;
+    std::vector<std::uint64_t> m_sortScratch;
+    std::vector<std::uint32_t> m_depthSequences; // by sort key index, increasing in painting order
+    std::uint32_t m_depthSequence{0};            // first depth value of the next flush
+    std::vector<BatchState> m_batchStates;
+    std::unordered_map<BatchState, int, BatchStateHash> m_batchStateIds;
+    int m_batchStateId{InvalidBatchState};
+    int m_instancedBatchStateId{InvalidBatchState};
+    std::vector<BatchRun> m_batchRuns;
+    std::vector<Batch> m_batches;
+    std::vector<bool> m_stateBatched; // by state id, while building batches
+    std::vector<DrawBatch> m_drawBatches;
+    std::vector<RenderList *> m_recordingLists;
+    bool m_frameRetained{false};
+    std::vector<std::byte> m_retainedData;
+    std::vector<DrawBatch> m_retainedBatches;
+    bool m_batchMergingEnabled{false};
+    bool m_instancingEnabled{false};
+    bool m_depthTestEnabled{false};
+    bool m_multiTextureEnabled{false};
+    int m_mergedBatchCount{0};
+    ShrinkPolicy m_shrinkPolicy{ShrinkPolicy::HighWaterMark};
+    std::size_t m_highWaterMark{0};
+    int m_framesSinceShrink{0};
+    gl::RingBuffer m_vertexBuffer;
     gl::Buffer m_indexBuffer;
     gl::VertexArray m_vao;
+    gl::Buffer m_quadVertexBuffer;
+    gl::Buffer m_quadIndexBuffer;
+    gl::VertexArray m_instancedVao;
     glm::mat4 m_mvp;
     Transform m_transform;
     ShaderManager::ProgramHandle m_batchProgram{ShaderManager::ProgramHandle::Invalid};
     const AbstractTexture *m_batchTexture{nullptr};
     const AbstractTexture *m_batchGradientTexture{nullptr};
     BlendFunc m_batchBlendFunc{BlendFunc::Factor::SourceAlpha, BlendFunc::Factor::OneMinusSourceAlpha};
-    bool m_bufferAllocated{false};
-    int m_quadIndex{0};
+    std::size_t m_indexQuadCapacity{0};
+
+    friend class RenderList;
 };
 
 } // namespace muui
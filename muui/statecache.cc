@@ -0,0 +1,240 @@
+#include "statecache.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace muui::gl
+{
+
+StateCache::StateCache() = default;
+
+void StateCache::invalidate()
+{
+    m_textures.fill(std::nullopt);
+    m_activeTextureUnit.reset();
+    m_program.reset();
+    m_arrayBuffer.reset();
+    m_elementArrayBuffer.reset();
+    m_vertexArray.reset();
+    m_framebuffer.reset();
+    m_renderbuffer.reset();
+    m_viewport.reset();
+    m_capabilities.fill(std::nullopt);
+    m_blendFunc.reset();
+    m_depthFunc.reset();
+    m_depthMask.reset();
+    m_unpackAlignment.reset();
+}
+
+void StateCache::setActiveTextureUnit(int unit)
+{
+    if (m_activeTextureUnit == unit)
+        return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    m_activeTextureUnit = unit;
+}
+
+void StateCache::bindTexture(int unit, GLenum target, GLuint texture)
+{
+    assert(unit >= 0 && unit < ScratchTextureUnit);
+    setTextureBinding(unit, target, texture);
+}
+
+void StateCache::setTextureBinding(int unit, GLenum target, GLuint texture)
+{
+    const auto binding = TextureBinding{target, texture};
+    if (m_textures[unit] == binding)
+        return;
+    setActiveTextureUnit(unit);
+    glBindTexture(target, texture);
+    m_textures[unit] = binding;
+}
+
+void StateCache::bindTextureForUpdate(GLenum target, GLuint texture)
+{
+    // avoid switching units if the texture is bound to the active one already
+    const auto binding = TextureBinding{target, texture};
+    if (m_activeTextureUnit && m_textures[*m_activeTextureUnit] == binding)
+        return;
+    setTextureBinding(ScratchTextureUnit, target, texture);
+}
+
+void StateCache::deleteTexture(GLuint texture)
+{
+    // deleted textures are unbound, and the name can be reused
+    for (auto &binding : m_textures)
+    {
+        if (binding && binding->texture == texture)
+            binding.reset();
+    }
+}
+
+void StateCache::useProgram(GLuint program)
+{
+    if (m_program == program)
+        return;
+    glUseProgram(program);
+    m_program = program;
+}
+
+void StateCache::deleteProgram(GLuint program)
+{
+    if (m_program == program)
+        m_program.reset();
+}
+
+std::optional<GLuint> *StateCache::bufferBinding(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER:
+        return &m_arrayBuffer;
+    case GL_ELEMENT_ARRAY_BUFFER:
+        return &m_elementArrayBuffer;
+    default:
+        return nullptr;
+    }
+}
+
+void StateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    auto *binding = bufferBinding(target);
+    if (binding && *binding == buffer)
+        return;
+    glBindBuffer(target, buffer);
+    if (binding)
+        *binding = buffer;
+}
+
+void StateCache::deleteBuffer(GLuint buffer)
+{
+    if (m_arrayBuffer == buffer)
+        m_arrayBuffer.reset();
+    if (m_elementArrayBuffer == buffer)
+        m_elementArrayBuffer.reset();
+}
+
+void StateCache::bindVertexArray(GLuint vertexArray)
+{
+    if (m_vertexArray == vertexArray)
+        return;
+    glBindVertexArray(vertexArray);
+    m_vertexArray = vertexArray;
+    m_elementArrayBuffer.reset();
+}
+
+void StateCache::deleteVertexArray(GLuint vertexArray)
+{
+    if (m_vertexArray == vertexArray)
+    {
+        // deleting the bound vertex array binds the default one
+        m_vertexArray = 0;
+        m_elementArrayBuffer.reset();
+    }
+}
+
+void StateCache::bindFramebuffer(GLuint framebuffer)
+{
+    if (m_framebuffer == framebuffer)
+        return;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    m_framebuffer = framebuffer;
+}
+
+void StateCache::bindRenderbuffer(GLuint renderbuffer)
+{
+    if (m_renderbuffer == renderbuffer)
+        return;
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    m_renderbuffer = renderbuffer;
+}
+
+void StateCache::deleteFramebuffer(GLuint framebuffer, GLuint renderbuffer)
+{
+    // deleting the bound framebuffer binds the default one
+    if (m_framebuffer == framebuffer)
+        m_framebuffer = 0;
+    if (m_renderbuffer == renderbuffer)
+        m_renderbuffer = 0;
+}
+
+void StateCache::setViewport(const Viewport &viewport)
+{
+    if (m_viewport == viewport)
+        return;
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    m_viewport = viewport;
+}
+
+std::optional<bool> *StateCache::capabilityState(GLenum capability)
+{
+    const auto it = std::find(std::begin(CachedCapabilities), std::end(CachedCapabilities), capability);
+    if (it == std::end(CachedCapabilities))
+        return nullptr;
+    return &m_capabilities[std::distance(std::begin(CachedCapabilities), it)];
+}
+
+void StateCache::setEnabled(GLenum capability, bool enabled)
+{
+    auto *cached = capabilityState(capability);
+    if (cached && *cached == enabled)
+        return;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+    if (cached)
+        *cached = enabled;
+}
+
+bool StateCache::isEnabled(GLenum capability)
+{
+    auto *cached = capabilityState(capability);
+    if (cached && cached->has_value())
+        return **cached;
+    const bool enabled = glIsEnabled(capability) == GL_TRUE;
+    if (cached)
+        *cached = enabled;
+    return enabled;
+}
+
+void StateCache::setBlendFunc(GLenum sourceFactor, GLenum destFactor)
+{
+    const auto blendFunc = std::array{sourceFactor, destFactor};
+    if (m_blendFunc == blendFunc)
+        return;
+    glBlendFunc(sourceFactor, destFactor);
+    m_blendFunc = blendFunc;
+}
+
+void StateCache::setDepthFunc(GLenum func)
+{
+    if (m_depthFunc == func)
+        return;
+    glDepthFunc(func);
+    m_depthFunc = func;
+}
+
+void StateCache::setDepthMask(bool enabled)
+{
+    if (m_depthMask == enabled)
+        return;
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+    m_depthMask = enabled;
+}
+
+void StateCache::setUnpackAlignment(GLint alignment)
+{
+    if (m_unpackAlignment == alignment)
+        return;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    m_unpackAlignment = alignment;
+}
+
+StateCache &stateCache()
+{
+    static StateCache cache;
+    return cache;
+}
+
+} // namespace muui::gl
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "gl.h"
+#include "noncopyable.h"
+
+#include <array>
+#include <optional>
+
+namespace muui::gl
+{
+
+// Shadow copy of the GL state changed by muui, so that changing it to the value it already has doesn't reach the
+// driver. Everything starts out unknown. Code that changes the same state with direct GL calls must call invalidate()
+// afterwards, Application does it at the start of every frame.
+class StateCache : private NonCopyable
+{
+public:
+    StateCache();
+
+    void invalidate();
+
+    // Units below ScratchTextureUnit keep their textures until bindTexture() replaces them
+    void bindTexture(int unit, GLenum target, GLuint texture);
+    // Binds the texture so that it can be modified, on the scratch unit unless it's bound to the active one already
+    void bindTextureForUpdate(GLenum target, GLuint texture);
+    void deleteTexture(GLuint texture);
+
+    void useProgram(GLuint program);
+    void deleteProgram(GLuint program);
+
+    void bindBuffer(GLenum target, GLuint buffer);
+    void deleteBuffer(GLuint buffer);
+
+    void bindVertexArray(GLuint vertexArray);
+    void deleteVertexArray(GLuint vertexArray);
+
+    void bindFramebuffer(GLuint framebuffer);
+    std::optional<GLuint> framebuffer() const { return m_framebuffer; }
+    void bindRenderbuffer(GLuint renderbuffer);
+    std::optional<GLuint> renderbuffer() const { return m_renderbuffer; }
+    void deleteFramebuffer(GLuint framebuffer, GLuint renderbuffer);
+
+    using Viewport = std::array<GLint, 4>;
+    void setViewport(const Viewport &viewport);
+    std::optional<Viewport> viewport() const { return m_viewport; }
+
+    // GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE and GL_SCISSOR_TEST are cached, other capabilities are passed through
+    void setEnabled(GLenum capability, bool enabled);
+    bool isEnabled(GLenum capability);
+
+    void setBlendFunc(GLenum sourceFactor, GLenum destFactor);
+    void setDepthFunc(GLenum func);
+    void setDepthMask(bool enabled);
+    void setUnpackAlignment(GLint alignment);
+
+    static constexpr int MaxTextureUnits = 16;
+    static constexpr int ScratchTextureUnit = MaxTextureUnits - 1; // reserved for uploads
+
+private:
+    static constexpr GLenum CachedCapabilities[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST};
+
+    struct TextureBinding
+    {
+        GLenum target;
+        GLuint texture;
+        bool operator==(const TextureBinding &) const = default;
+    };
+
+    void setActiveTextureUnit(int unit);
+    void setTextureBinding(int unit, GLenum target, GLuint texture);
+    std::optional<bool> *capabilityState(GLenum capability);
+    std::optional<GLuint> *bufferBinding(GLenum target);
+
+    std::array<std::optional<TextureBinding>, MaxTextureUnits> m_textures;
+    std::optional<int> m_activeTextureUnit;
+    std::optional<GLuint> m_program;
+    std::optional<GLuint> m_arrayBuffer;
+    std::optional<GLuint> m_elementArrayBuffer; // part of the vertex array state
+    std::optional<GLuint> m_vertexArray;
+    std::optional<GLuint> m_framebuffer;
+    std::optional<GLuint> m_renderbuffer;
+    std::optional<Viewport> m_viewport;
+    std::array<std::optional<bool>, std::size(CachedCapabilities)> m_capabilities;
+    std::optional<std::array<GLenum, 2>> m_blendFunc;
+    std::optional<GLenum> m_depthFunc;
+    std::optional<bool> m_depthMask;
+    std::optional<GLint> m_unpackAlignment;
+};
+
+StateCache &stateCache();
+
+} // namespace muui::gl
@@ -1,12 +1,17 @@
 #include "system.h"
 
+#include "animator.h"
 #include "fontcache.h"
+#include "framedamage.h"
 #include "pixmapcache.h"
+#include "renderstats.h"
 #include "shadermanager.h"
 #include "textureatlas.h"
 
 #include <SDL.h>
 
+#include <atomic>
+
 namespace muui::sys
 {
 
@@ -26,6 +31,8 @@ struct System
     ShaderManager *shaderManager() { return m_shaderManager.get(); }
     FontCache *fontCache() { return m_fontCache.get(); }
     PixmapCache *pixmapCache() { return m_pixmapCache.get(); }
+    RenderStats *renderStats() { return &m_renderStats; }
+    FrameDamage *frameDamage() { return &m_frameDamage; }
 
     static constexpr auto TextureAtlasPageSize = 1024;
 
@@ -33,8 +40,13 @@ struct System
     std::unique_ptr<TextureAtlas> m_textureAtlas;
     std::unique_ptr<FontCache> m_fontCache;
     std::unique_ptr<PixmapCache> m_pixmapCache;
+    RenderStats m_renderStats;
+    FrameDamage m_frameDamage;
 } *s_system = nullptr;
 
+std::atomic<bool> s_updateRequested = false;
+std::atomic<bool> s_waitingForEvent = false;
+
 } // namespace
 
 bool initialize()
@@ -51,6 +63,12 @@ void shutdown()
     s_system = nullptr;
 }
 
+Animator *animator()
+{
+    static Animator animator;
+    return &animator;
+}
+
 ShaderManager *shaderManager()
 {
     return s_system->shaderManager();
@@ -66,4 +84,46 @@ PixmapCache *pixmapCache()
     return s_system->pixmapCache();
 }
 
+void requestUpdate()
+{
+    if (s_updateRequested.exchange(true))
+        return;
+    // wake up waitEvent(), it checks the request after announcing that it's waiting so one of the two sees the other
+    static const auto wakeUpEvent = SDL_RegisterEvents(1);
+    if (s_waitingForEvent && wakeUpEvent != static_cast<Uint32>(-1))
+    {
+        SDL_Event event = {};
+        event.type = wakeUpEvent;
+        SDL_PushEvent(&event);
+    }
+}
+
+bool updateRequested()
+{
+    return s_updateRequested;
+}
+
+bool takeUpdateRequest()
+{
+    return s_updateRequested.exchange(false);
+}
+
+bool waitEvent(SDL_Event *event, int timeout)
+{
+    s_waitingForEvent = true;
+    const bool received = !s_updateRequested && SDL_WaitEventTimeout(event, timeout) == 1;
+    s_waitingForEvent = false;
+    return received;
+}
+
+RenderStats *renderStats()
+{
+    return s_system->renderStats();
+}
+
+FrameDamage *frameDamage()
+{
+    return s_system->frameDamage();
+}
+
 } // namespace muui::sys
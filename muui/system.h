@@ -1,10 +1,15 @@
 #pragma once
 
+union SDL_Event;
+
 namespace muui
 {
+class Animator;
 class FontCache;
 class PixmapCache;
 class ShaderManager;
+struct RenderStats;
+struct FrameDamage;
 } // namespace muui
 
 namespace muui::sys
@@ -13,8 +18,21 @@ namespace muui::sys
 ShaderManager *shaderManager();
 FontCache *fontCache();
 PixmapCache *pixmapCache();
+RenderStats *renderStats();
+FrameDamage *frameDamage();
+
+// Can be used before initialize()
+Animator *animator();
 
 bool initialize();
 void shutdown();
 
+// Asks for another frame to be rendered, see Application::setRenderOnDemand(). Can be called from any thread, and
+// before initialize().
+void requestUpdate();
+bool updateRequested();
+bool takeUpdateRequest();
+// Waits for the next event, returns false if the timeout expired or an update was already requested
+bool waitEvent(SDL_Event *event, int timeout);
+
 } // namespace muui::sys
@@ -0,0 +1,40 @@
+#include "textlayout.h"
+
+#include "font.h"
+
+#include <cassert>
+
+namespace muui
+{
+
+void TextLayout::setFont(Font *font)
+{
+    if (font == m_font)
+        return;
+    m_font = font;
+    clear();
+}
+
+void TextLayout::clear()
+{
+    m_glyphs.clear();
+    m_bounds = {};
+}
+
+void TextLayout::addText(std::u32string_view text, const glm::vec2 &pos)
+{
+    assert(m_font);
+    auto basePos = glm::vec2(pos.x, pos.y + m_font->ascent());
+    for (auto ch : text)
+    {
+        if (const auto *glyph = m_font->glyph(ch))
+        {
+            const auto rect = glyph->boundingBox + basePos;
+            m_bounds = m_glyphs.empty() ? rect : m_bounds | rect;
+            m_glyphs.push_back({.rect = rect, .texCoord = glyph->pixmap.texCoord, .texture = glyph->pixmap.texture});
+            basePos.x += glyph->advanceWidth;
+        }
+    }
+}
+
+} // namespace muui
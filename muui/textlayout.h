@@ -0,0 +1,45 @@
+#pragma once
+
+#include "util.h"
+
+#include <glm/glm.hpp>
+
+#include <string_view>
+#include <vector>
+
+namespace muui
+{
+class AbstractTexture;
+class Font;
+
+// Glyph quads positioned once and drawn with Painter::drawTextLayout() until the text changes, so that drawing static
+// text doesn't look up and place every glyph again on every frame.
+class TextLayout
+{
+public:
+    struct GlyphQuad
+    {
+        RectF rect;
+        RectF texCoord;
+        const AbstractTexture *texture;
+    };
+
+    // the layout is cleared when the font changes
+    void setFont(Font *font);
+    Font *font() const { return m_font; }
+
+    void clear();
+    // `pos` is the top left corner of the line, as in Painter::drawText()
+    void addText(std::u32string_view text, const glm::vec2 &pos);
+
+    const std::vector<GlyphQuad> &glyphs() const { return m_glyphs; }
+    const RectF &bounds() const { return m_bounds; } // of the glyph quads
+    bool isEmpty() const { return m_glyphs.empty(); }
+
+private:
+    Font *m_font{nullptr};
+    std::vector<GlyphQuad> m_glyphs;
+    RectF m_bounds;
+};
+
+} // namespace muui
@@ -1,5 +1,6 @@
 #include "texture.h"
 #include "pixmap.h"
+#include "statecache.h"
 
 #include <algorithm>
 #include <cassert>
@@ -13,12 +14,20 @@ namespace
 {
 GLenum toGLFormat(PixelType pixelType)
 {
-    return pixelType == PixelType::RGBA ? GL_RGBA : GL_LUMINANCE;
+    switch (pixelType)
+    {
+    case PixelType::RGBA:
+        return GL_RGBA;
+    case PixelType::RGB:
+        return GL_RGB;
+    default:
+        return GL_LUMINANCE;
+    }
 }
 
 GLenum toGLInternalFormat(PixelType pixelType)
 {
-    return pixelType == PixelType::RGBA ? GL_RGBA : GL_LUMINANCE;
+    return toGLFormat(pixelType);
 }
 } // namespace
 
@@ -42,7 +51,10 @@ Texture::Texture(int width, int height, PixelType pixelType, const unsigned char
 Texture::~Texture()
 {
     if (m_id)
+    {
+        stateCache().deleteTexture(m_id);
         glDeleteTextures(1, &m_id);
+    }
 }
 
 Texture::Texture(Texture &&other)
@@ -70,8 +82,8 @@ void swap(Texture &lhs, Texture &rhs)
 
 void Texture::initialize()
 {
-    bind();
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bindForUpdate();
+    stateCache().setUnpackAlignment(1);
     switch (m_target)
     {
     case Target::TextureCubeMap:
@@ -86,44 +98,44 @@ void Texture::initialize()
 
 void Texture::setMinificationFilter(Filter filter)
 {
-    bind();
+    bindForUpdate();
     glTexParameteri(static_cast<GLenum>(m_target), GL_TEXTURE_MIN_FILTER, static_cast<GLint>(filter));
 }
 
 void Texture::setMagnificationFilter(Filter filter)
 {
-    bind();
+    bindForUpdate();
     glTexParameteri(static_cast<GLenum>(m_target), GL_TEXTURE_MAG_FILTER, static_cast<GLint>(filter));
 }
 
 void Texture::setWrapModeS(WrapMode mode)
 {
-    bind();
+    bindForUpdate();
     glTexParameteri(static_cast<GLenum>(m_target), GL_TEXTURE_WRAP_S, static_cast<GLint>(mode));
 }
 
 void Texture::setWrapModeT(WrapMode mode)
 {
-    bind();
+    bindForUpdate();
     glTexParameteri(static_cast<GLenum>(m_target), GL_TEXTURE_WRAP_T, static_cast<GLint>(mode));
 }
 
 void Texture::setWrapModeR(WrapMode mode)
 {
-    bind();
+    bindForUpdate();
     glTexParameteri(static_cast<GLenum>(m_target), GL_TEXTURE_WRAP_R, static_cast<GLint>(mode));
 }
 
 void Texture::allocateTextureData(std::size_t faceIndex) const
 {
-    bind();
+    bindForUpdate();
     glTexImage2D(faceTarget(faceIndex), 0, toGLInternalFormat(m_pixelType), m_width, m_height, 0,
                  toGLFormat(m_pixelType), GL_UNSIGNED_BYTE, nullptr);
 }
 
 void Texture::setData(const unsigned char *data, std::size_t faceIndex) const
 {
-    bind();
+    bindForUpdate();
     glTexSubImage2D(faceTarget(faceIndex), 0, 0, 0, m_width, m_height, toGLFormat(m_pixelType), GL_UNSIGNED_BYTE, data);
 }
 
@@ -142,8 +154,12 @@ GLenum Texture::faceTarget(std::size_t faceIndex) const
 
 void Texture::bind(int textureUnit) const
 {
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(static_cast<GLenum>(m_target), m_id);
+    stateCache().bindTexture(textureUnit, static_cast<GLenum>(m_target), m_id);
+}
+
+void Texture::bindForUpdate() const
+{
+    stateCache().bindTextureForUpdate(static_cast<GLenum>(m_target), m_id);
 }
 
 } // namespace muui::gl
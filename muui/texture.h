@@ -68,6 +68,7 @@ public:
 
 private:
     void initialize();
+    void bindForUpdate() const;
     GLenum faceTarget(std::size_t faceIndex = 0) const;
     void allocateTextureData(std::size_t faceIndex = 0) const;
     int m_width{0};
@@ -94,4 +94,18 @@ glm::vec2 Transform::map(const glm::vec2 &p) const
     }
 }
 
+glm::mat3 Transform::matrix() const
+{
+    switch (m_type)
+    {
+    case Type::Identity:
+        return glm::mat3(1.0f);
+    case Type::Translation:
+        return glm::translate(glm::mat3(1.0f), m_translation);
+    default:
+    case Type::General:
+        return m_transform;
+    }
+}
+
 } // namespace muui
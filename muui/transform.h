@@ -14,6 +14,9 @@ public:
     void scale(const glm::vec2 &s);
 
     glm::vec2 map(const glm::vec2 &p) const;
+    glm::mat3 matrix() const;
+
+    bool operator==(const Transform &other) const = default;
 
 private:
     enum class Type
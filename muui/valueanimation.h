@@ -1,5 +1,9 @@
 #pragma once
 
+#include "animator.h"
+#include "noncopyable.h"
+#include "system.h"
+
 #include <muslots/muslots.h>
 
 #include <glm/glm.hpp>
@@ -7,12 +11,21 @@
 namespace muui
 {
 
+// Advanced by sys::animator() while it's running. The start and end values and the duration are read when the
+// animation starts.
 template<typename F>
-class ValueAnimation
+class ValueAnimation : private NonCopyable
 {
 public:
     using T = typename F::Type;
 
+    ValueAnimation() = default;
+    ~ValueAnimation()
+    {
+        if (m_group)
+            m_group->remove(m_slot);
+    }
+
     T startValue = T{};
     T endValue = T{};
     float duration = 0.0f;
@@ -20,36 +33,28 @@ public:
     T value() const
     {
         constexpr F tweener;
-        float t = std::min(m_t / duration, 1.0f);
+        float t = duration > 0.0f ? std::min(m_t / duration, 1.0f) : 1.0f;
         return glm::mix(startValue, endValue, tweener(t));
     }
 
-    void update(float elapsed)
-    {
-        if (!m_active)
-            return;
-        float t = m_t + elapsed;
-        if (t == m_t)
-            return;
-        if (t > duration)
-        {
-            t = duration;
-            m_active = false;
-        }
-        m_t = t;
-        valueChangedSignal(value());
-        if (!m_active)
-            finishedSignal();
-    }
-
     void start()
     {
         m_t = 0.0f;
         m_active = true;
+        if (m_group)
+            m_group->restart(m_slot);
+        else
+            sys::animator()->group<F>()->add(this);
+        sys::requestUpdate();
         valueChangedSignal(value());
     }
 
-    void stop() { m_active = false; }
+    void stop()
+    {
+        m_active = false;
+        if (m_group)
+            m_group->remove(m_slot);
+    }
 
     bool active() const { return m_active; }
 
@@ -59,5 +64,9 @@ public:
 private:
     float m_t = 0.0f;
     bool m_active = false;
+    Animator::TweenGroup<F> *m_group = nullptr;
+    std::size_t m_slot = 0;
+
+    friend class Animator;
 };
 } // namespace muui
@@ -1,5 +1,7 @@
 #include "vertexarray.h"
 
+#include "statecache.h"
+
 #include <utility>
 
 namespace muui::gl
@@ -12,7 +14,11 @@ VertexArray::VertexArray()
 
 VertexArray::~VertexArray()
 {
-    glDeleteVertexArrays(1, &m_handle);
+    if (m_handle)
+    {
+        stateCache().deleteVertexArray(m_handle);
+        glDeleteVertexArrays(1, &m_handle);
+    }
 }
 
 VertexArray::VertexArray(VertexArray &&other)
@@ -34,12 +40,12 @@ void swap(VertexArray &lhs, VertexArray &rhs)
 
 void VertexArray::bind() const
 {
-    glBindVertexArray(m_handle);
+    stateCache().bindVertexArray(m_handle);
 }
 
 void VertexArray::unbind() const
 {
-    glBindVertexArray(0);
+    stateCache().bindVertexArray(0);
 }
 
 } // namespace muui::gl
@@ -0,0 +1,102 @@
+#include <muui/animator.h>
+#include <muui/system.h>
+#include <muui/tweening.h>
+#include <muui/valueanimation.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+using namespace muui;
+
+TEST_CASE("Animator", "[animator]")
+{
+    auto *animator = sys::animator();
+    REQUIRE(animator->activeCount() == 0);
+
+    ValueAnimation<tweening::Linear<float>> linear;
+    linear.startValue = 0.0f;
+    linear.endValue = 10.0f;
+    linear.duration = 1.0f;
+    std::vector<float> values;
+    int finishedCount = 0;
+    linear.valueChangedSignal.connect([&values](float value) { values.push_back(value); });
+    linear.finishedSignal.connect([&finishedCount] { ++finishedCount; });
+
+    ValueAnimation<tweening::InQuadratic<float>> quadratic;
+    quadratic.startValue = 0.0f;
+    quadratic.endValue = 1.0f;
+    quadratic.duration = 1.0f;
+
+    linear.start();
+    quadratic.start();
+    REQUIRE(animator->activeCount() == 2);
+    REQUIRE(values == std::vector<float>{0.0f});
+
+    animator->update(0.5f);
+    REQUIRE(values == std::vector<float>{0.0f, 5.0f});
+    REQUIRE(quadratic.value() == 0.25f);
+
+    // stopped animations aren't advanced
+    quadratic.stop();
+    REQUIRE(animator->activeCount() == 1);
+    animator->update(0.25f);
+    REQUIRE(quadratic.value() == 0.25f);
+    REQUIRE(values.back() == 7.5f);
+
+    // frames too short to advance anything still ask for the next one
+    sys::takeUpdateRequest();
+    animator->update(0.0f);
+    REQUIRE(sys::updateRequested());
+    REQUIRE(values.back() == 7.5f);
+
+    // finished animations unregister themselves
+    animator->update(1.0f);
+    REQUIRE(values.back() == 10.0f);
+    REQUIRE(finishedCount == 1);
+    REQUIRE(!linear.active());
+    REQUIRE(animator->activeCount() == 0);
+
+    // animations can be restarted from their signals
+    linear.finishedSignal.connect([&linear, &finishedCount] {
+        if (finishedCount < 3)
+            linear.start();
+    });
+    linear.start();
+    animator->update(1.0f);
+    REQUIRE(finishedCount == 2);
+    REQUIRE(linear.active());
+    REQUIRE(animator->activeCount() == 1);
+    animator->update(1.0f);
+    REQUIRE(finishedCount == 3);
+    REQUIRE(animator->activeCount() == 0);
+
+    // animations restarted by handlers during an update start over on the next one
+    {
+        ValueAnimation<tweening::Linear<float>> first;
+        first.duration = 1.0f;
+        ValueAnimation<tweening::Linear<float>> second;
+        second.endValue = 10.0f;
+        second.duration = 1.0f;
+        std::vector<float> secondValues;
+        second.valueChangedSignal.connect([&secondValues](float value) { secondValues.push_back(value); });
+        first.valueChangedSignal.connect([&second](float) { second.start(); });
+        first.start();
+        second.start();
+        secondValues.clear();
+        animator->update(0.5f);
+        REQUIRE(secondValues == std::vector<float>{0.0f});
+        REQUIRE(second.value() == 0.0f);
+        REQUIRE(animator->activeCount() == 2);
+    }
+    REQUIRE(animator->activeCount() == 0);
+
+    // destroyed animations unregister themselves
+    {
+        ValueAnimation<tweening::Linear<float>> animation;
+        animation.duration = 1.0f;
+        animation.start();
+        REQUIRE(animator->activeCount() == 1);
+    }
+    REQUIRE(animator->activeCount() == 0);
+}
@@ -0,0 +1,79 @@
+#include <muui/item.h>
+#include <muui/system.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <functional>
+
+using namespace muui;
+
+namespace
+{
+
+// what Screen does with partial updates, without the GL resources of a screen
+class DamageRoot : public Rectangle
+{
+public:
+    DamageRoot()
+        : Rectangle(100, 100)
+    {
+    }
+
+    std::optional<RectF> takeDamage()
+    {
+        layout();
+        std::optional<RectF> damage;
+        updateBounds(Transform{}, damage);
+        return damage;
+    }
+};
+
+} // namespace
+
+TEST_CASE("Appearance changes damage the item", "[damage]")
+{
+    DamageRoot root;
+    auto *child = root.appendChild<Rectangle>(10, 20);
+    root.takeDamage();
+    REQUIRE(!root.takeDamage());
+    const auto childBounds = child->bounds();
+    REQUIRE(childBounds);
+
+    const std::function<void()> changes[] = {
+        [child] { child->setFillBackground(true); },
+        [child] { child->setShape(Item::Shape::RoundedRectangle); },
+        [child] { child->setCornerRadius(4.0f); },
+        [child] { child->setBackgroundBrush(Color(1, 0, 0, 1)); },
+        [child] { child->setForegroundBrush(Color(0, 1, 0, 1)); },
+        [child] { child->setOutlineBrush(Color(0, 0, 1, 1)); },
+    };
+    for (const auto &change : changes)
+    {
+        change();
+        REQUIRE(root.takeDamage() == childBounds);
+    }
+
+    // hidden items damage the area they covered
+    child->setVisible(false);
+    REQUIRE(root.takeDamage() == childBounds);
+    REQUIRE(!child->bounds());
+    child->setVisible(true);
+    REQUIRE(root.takeDamage() == childBounds);
+}
+
+TEST_CASE("Laying out doesn't request another update", "[damage]")
+{
+    DamageRoot root;
+    auto *column = root.appendChild<Column>();
+    column->setMinimumWidth(100.0f);
+    auto *child = column->appendChild<Rectangle>(10, 20);
+    root.takeDamage();
+    sys::takeUpdateRequest();
+
+    child->setContainerAlignment(Alignment::Right);
+    REQUIRE(sys::takeUpdateRequest());
+    // the frame that lays the column out draws the moved child
+    const auto damage = root.takeDamage();
+    REQUIRE(!sys::updateRequested());
+    REQUIRE(damage == RectF{glm::vec2{0.0f}, glm::vec2{100.0f, 20.0f}});
+}
@@ -0,0 +1,100 @@
+#include <muui/item.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace muui;
+
+namespace
+{
+
+// what Screen does with setNameRegistryEnabled(), without the GL resources of a screen
+class RegistryRoot : public Rectangle
+{
+public:
+    RegistryRoot() { setNameRegistry(&registry); }
+    ~RegistryRoot() override { setNameRegistry(nullptr); }
+
+    NameRegistry registry;
+};
+
+template<typename RootT>
+void testFindChild(RootT &root)
+{
+    auto *column = root.template appendChild<Column>();
+    column->setObjectName("column");
+    auto *label = column->template appendChild<Rectangle>(10, 10);
+    label->setObjectName("score");
+    REQUIRE(root.template findChild<Rectangle>("score") == label);
+    REQUIRE(root.template findChild<Column>("column") == column);
+    REQUIRE(column->template findChild<Rectangle>("score") == label);
+
+    // type checked
+    REQUIRE(root.template findChild<Column>("score") == nullptr);
+
+    // only looks in the subtree
+    auto *other = root.template appendChild<Rectangle>(10, 10);
+    REQUIRE(other->template findChild<Rectangle>("score") == nullptr);
+
+    // renamed
+    label->setObjectName("highScore");
+    REQUIRE(root.template findChild<Rectangle>("score") == nullptr);
+    REQUIRE(root.template findChild<Rectangle>("highScore") == label);
+
+    // children of scroll areas
+    auto content = std::make_unique<Rectangle>(100, 100);
+    content->setObjectName("content");
+    auto *contentItem = content.get();
+    root.template appendChild<ScrollArea>(50, 50, std::move(content));
+    REQUIRE(root.template findChild<Rectangle>("content") == contentItem);
+
+    // removed
+    auto taken = root.takeChildAt(0);
+    REQUIRE(root.template findChild<Rectangle>("highScore") == nullptr);
+    REQUIRE(taken->template findChild<Rectangle>("highScore") == label);
+    root.removeChild(root.childCount() - 1);
+    REQUIRE(root.template findChild<Rectangle>("content") == nullptr);
+
+    // duplicate names, the first one depth first wins whatever order they were named in
+    auto *column2 = root.template appendChild<Column>();
+    auto *second = root.template appendChild<Rectangle>(10, 10);
+    second->setObjectName("duplicate");
+    auto *first = column2->template appendChild<Rectangle>(10, 10);
+    first->setObjectName("duplicate");
+    REQUIRE(root.template findChild<Item>("duplicate") == first);
+    column2->setObjectName("duplicate");
+    REQUIRE(root.template findChild<Item>("duplicate") == column2);
+    REQUIRE(root.template findChild<Rectangle>("duplicate") == first);
+    REQUIRE(column2->template findChild<Item>("duplicate") == column2);
+    REQUIRE(second->template findChild<Item>("duplicate") == second);
+    root.removeChild(root.childCount() - 2);
+    REQUIRE(root.template findChild<Item>("duplicate") == second);
+}
+
+} // namespace
+
+TEST_CASE("Find child", "[findchild]")
+{
+    Rectangle root{100, 100};
+    testFindChild(root);
+}
+
+TEST_CASE("Find child in name registry", "[findchild]")
+{
+    RegistryRoot root;
+    testFindChild(root);
+    REQUIRE(root.registry.items("highScore").empty());
+    REQUIRE(root.registry.items("column").empty());
+}
+
+TEST_CASE("Visit children", "[findchild]")
+{
+    auto content = std::make_unique<Rectangle>(100, 100);
+    auto *contentItem = content.get();
+    ScrollArea scrollArea(50, 50, std::move(content));
+    auto *child = scrollArea.appendChild<Rectangle>(10, 10);
+
+    std::vector<Item *> children;
+    scrollArea.forEachChild([&children](Item *item) { children.push_back(item); });
+    REQUIRE(children == std::vector<Item *>{child, contentItem});
+    REQUIRE(scrollArea.children() == children);
+}
@@ -0,0 +1,105 @@
+#include <muui/font.h>
+#include <muui/textureatlas.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <chrono>
+#include <string_view>
+#include <thread>
+
+using namespace muui;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+constexpr auto FontPath = ASSETSDIR "OpenSans_Bold.ttf";
+
+void waitForPreload(Font &font)
+{
+    while (font.preloading())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        font.commitPreloadedGlyphs();
+    }
+}
+
+} // namespace
+
+TEST_CASE("Preload glyphs", "[font]")
+{
+    for (const int outlineSize : {0, 4})
+    {
+        TextureAtlas textureAtlas(1024, 1024);
+        Font font(&textureAtlas);
+        REQUIRE(font.load(FontPath, 40, outlineSize));
+        Font reference(&textureAtlas);
+        REQUIRE(reference.load(FontPath, 40, outlineSize));
+
+        int finishedCount = 0;
+        font.preloadFinishedSignal.connect([&finishedCount] { ++finishedCount; });
+
+        constexpr std::array ranges = {Font::CodepointRange{U'0', U'9'}, Font::CodepointRange{U'A', U'Z'}};
+        font.preload(ranges);
+        REQUIRE(font.preloading());
+        waitForPreload(font);
+        REQUIRE(finishedCount == 1);
+
+        for (const auto codepoint : U"0123456789ABCXYZ"sv)
+        {
+            const auto *glyph = font.glyph(codepoint);
+            const auto *expected = reference.glyph(codepoint);
+            REQUIRE(glyph != nullptr);
+            REQUIRE(glyph->boundingBox == expected->boundingBox);
+            REQUIRE(glyph->advanceWidth == expected->advanceWidth);
+        }
+
+        // glyphs already there aren't rasterized again
+        const auto *glyph = font.glyph(U'A');
+        font.preload(U"ABC");
+        REQUIRE(!font.preloading());
+        font.preload(U"ABCabc");
+        waitForPreload(font);
+        REQUIRE(finishedCount == 2);
+        REQUIRE(font.glyph(U'A') == glyph);
+        REQUIRE(font.glyph(U'b')->boundingBox == reference.glyph(U'b')->boundingBox);
+    }
+}
+
+TEST_CASE("Distance field glyphs are shared across sizes", "[font]")
+{
+    TextureAtlas textureAtlas(1024, 1024);
+    Font distanceField(&textureAtlas);
+    REQUIRE(distanceField.loadDistanceField(FontPath));
+    REQUIRE(distanceField.isDistanceField());
+
+    Font small(&textureAtlas);
+    REQUIRE(small.load(&distanceField, 24));
+    Font large(&textureAtlas);
+    REQUIRE(large.load(&distanceField, 96, 4));
+    REQUIRE(large.isDistanceField());
+    REQUIRE(large.ascent() == 2.0f * distanceField.ascent());
+
+    const auto *g48 = distanceField.glyph(U'A');
+    const auto *g24 = small.glyph(U'A');
+    const auto *g96 = large.glyph(U'A');
+    REQUIRE(g24->pixmap.texture == g48->pixmap.texture);
+    REQUIRE(g96->pixmap.texCoord == g48->pixmap.texCoord);
+    REQUIRE(g96->advanceWidth == 2.0f * g48->advanceWidth);
+    REQUIRE(g24->boundingBox.min == 0.5f * g48->boundingBox.min);
+    REQUIRE(g96->boundingBox.max == 2.0f * g48->boundingBox.max);
+    REQUIRE(large.textWidth(U"AVA") == 4.0f * small.textWidth(U"AVA"));
+
+    REQUIRE(large.outlineEdge() < large.glyphEdge());
+    REQUIRE(large.outlineEdge() == distanceField.glyphEdge() * 0.75f);
+
+    int finishedCount = 0;
+    small.preloadFinishedSignal.connect([&finishedCount] { ++finishedCount; });
+    small.preload(U"xyz");
+    REQUIRE(small.preloading());
+    REQUIRE(distanceField.preloading());
+    waitForPreload(small);
+    REQUIRE(finishedCount == 1);
+    REQUIRE(large.glyph(U'x')->pixmap.texCoord == distanceField.glyph(U'x')->pixmap.texCoord);
+}
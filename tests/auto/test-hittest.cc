@@ -0,0 +1,72 @@
+#include <muui/item.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace muui;
+
+namespace
+{
+
+class Target : public Rectangle
+{
+public:
+    using Rectangle::Rectangle;
+
+protected:
+    Item *handleMouseEvent(const TouchEvent &event) override
+    {
+        return rect().contains(event.position) ? this : nullptr;
+    }
+};
+
+Item *press(Item &root, const glm::vec2 &pos)
+{
+    return root.mouseEvent({TouchEvent::Type::Press, pos});
+}
+
+} // namespace
+
+TEST_CASE("Hit test", "[hittest]")
+{
+    // enough children to use a grid
+    constexpr auto GridSize = 20;
+    Rectangle canvas{GridSize * 10, GridSize * 10};
+    std::vector<Target *> targets;
+    for (int y = 0; y < GridSize; ++y)
+    {
+        for (int x = 0; x < GridSize; ++x)
+        {
+            auto *target = canvas.appendChild<Target>(10, 10);
+            target->setLeft(Length::pixels(x * 10));
+            target->setTop(Length::pixels(y * 10));
+            targets.push_back(target);
+        }
+    }
+    REQUIRE(press(canvas, {5, 5}) == targets[0]);
+    REQUIRE(press(canvas, {37, 52}) == targets[5 * GridSize + 3]);
+    REQUIRE(press(canvas, {199, 199}) == targets.back());
+    REQUIRE(press(canvas, {200, 5}) == nullptr);
+
+    // items drawn last are hit first
+    auto *top = canvas.appendChild<Target>(30, 30);
+    top->setLeft(Length::pixels(25));
+    top->setTop(Length::pixels(25));
+    REQUIRE(press(canvas, {30, 30}) == top);
+    REQUIRE(press(canvas, {60, 30}) == targets[3 * GridSize + 6]);
+
+    // children outside of their parent's rect
+    auto *group = canvas.appendChild<Rectangle>(10, 10);
+    group->setLeft(Length::pixels(100));
+    group->setTop(Length::pixels(100));
+    auto *overflowing = group->appendChild<Target>(10, 10);
+    overflowing->setLeft(Length::pixels(150));
+    REQUIRE(press(canvas, {255, 105}) == overflowing);
+
+    // rotated children
+    auto *rotated = canvas.appendChild<Target>(40, 10);
+    rotated->setLeft(Length::pixels(300));
+    rotated->setTransformOrigin({0, 0});
+    rotated->setRotation(0.5f * glm::pi<float>());
+    REQUIRE(press(canvas, {295, 20}) == rotated);
+    REQUIRE(press(canvas, {305, 20}) == nullptr);
+}
@@ -4,6 +4,17 @@
 
 using namespace muui;
 
+namespace
+{
+
+class TestColumn : public Column
+{
+public:
+    using Column::visibleChildRange;
+};
+
+} // namespace
+
 TEST_CASE("Column layout", "[layouts]")
 {
     Column column;
@@ -97,3 +108,49 @@ TEST_CASE("Row layout", "[layouts]")
     row.setMargins(Margins{10, 20, 30, 40});
     REQUIRE(row.size() == Size{220, 60});
 }
+
+TEST_CASE("Deferred layout", "[layouts]")
+{
+    Column column;
+    column.setSpacing(1);
+    int resizeCount = 0;
+    column.resizedSignal.connect([&resizeCount](Size) { ++resizeCount; });
+
+    // changes are only recorded until the layout is needed
+    constexpr auto RowCount = 1000;
+    for (int i = 0; i < RowCount; ++i)
+        column.appendChild<Rectangle>(10, 20);
+    REQUIRE(resizeCount == 0);
+
+    REQUIRE(column.size() == Size{10, RowCount * 20 + (RowCount - 1)});
+    REQUIRE(resizeCount == 1);
+    REQUIRE(column.childRect(RowCount - 1).min == glm::vec2{0.0f, (RowCount - 1) * 21});
+
+    // nested containers are resolved children first
+    auto *row = column.appendChild<Row>();
+    row->appendChild<Rectangle>(30, 5);
+    row->appendChild<Rectangle>(40, 5);
+    REQUIRE(column.size() == Size{70, RowCount * 20 + RowCount + 5});
+    REQUIRE(resizeCount == 2);
+}
+
+TEST_CASE("Visible children", "[layouts]")
+{
+    TestColumn column;
+    for (int i = 0; i < 100; ++i)
+        column.appendChild<Rectangle>(100, 10);
+    column.layout();
+
+    using Range = std::pair<std::size_t, std::size_t>;
+    const auto clipRect = RectF{{0, 205}, {100, 255}};
+    REQUIRE(column.visibleChildRange(clipRect) == Range{20, 26});
+    REQUIRE(column.visibleChildRange(RectF{{0, -50}, {100, -10}}) == Range{0, 0});
+    REQUIRE(column.visibleChildRange(RectF{{0, 990}, {100, 1200}}) == Range{99, 100});
+
+    // children drawn outside of their rect widen the range
+    auto *overflowing = column.childAt(50)->appendChild<Rectangle>(10, 10);
+    overflowing->setTop(Length::pixels(-30));
+    column.layout();
+    REQUIRE(column.subtreeBounds() == RectF{{0, 0}, {100, 1000}});
+    REQUIRE(column.visibleChildRange(clipRect) == Range{17, 29});
+}
@@ -0,0 +1,89 @@
+#include <muui/item.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <set>
+
+using namespace muui;
+
+namespace
+{
+
+class TestModel : public ListModel
+{
+public:
+    std::size_t rowCount() const override { return m_rowCount; }
+
+    std::unique_ptr<Item> createDelegate() override
+    {
+        ++createCount;
+        return std::make_unique<Rectangle>(100, 10);
+    }
+
+    void bindDelegate(Item *delegate, std::size_t row) override
+    {
+        ++bindCount;
+        delegate->setObjectName(std::to_string(row));
+    }
+
+    void setRowCount(std::size_t rowCount)
+    {
+        m_rowCount = rowCount;
+        modelResetSignal();
+    }
+
+    int createCount = 0;
+    int bindCount = 0;
+
+private:
+    std::size_t m_rowCount = 0;
+};
+
+std::set<std::string> boundRows(const ListView &view)
+{
+    std::set<std::string> rows;
+    for (const auto *child : view.children())
+        rows.insert(child->objectName());
+    return rows;
+}
+
+} // namespace
+
+TEST_CASE("List view", "[listview]")
+{
+    TestModel model;
+    model.setRowCount(50000);
+
+    ListView view(&model);
+    view.setViewportSize({100, 100});
+    REQUIRE(view.size() == Size{100, 100});
+
+    // enough delegates to fill the viewport, plus a few above and below it
+    const auto delegateCount = view.children().size();
+    REQUIRE(delegateCount < 20);
+    REQUIRE(model.createCount == static_cast<int>(delegateCount));
+    REQUIRE(boundRows(view).contains("0"));
+
+    // scrolling reuses the delegates
+    view.setContentOffset(10000);
+    REQUIRE(view.contentOffset() == 10000);
+    REQUIRE(view.children().size() == delegateCount);
+    REQUIRE(model.createCount == static_cast<int>(delegateCount));
+    REQUIRE(boundRows(view).contains("1000"));
+    REQUIRE(boundRows(view).contains("1009"));
+
+    // scrolling by one row binds a single delegate
+    const auto bindCount = model.bindCount;
+    view.setContentOffset(10010);
+    REQUIRE(view.contentOffset() == 10010);
+    REQUIRE(model.bindCount == bindCount + 1);
+
+    // the offset is clamped to the content
+    view.setContentOffset(1e9f);
+    REQUIRE(view.contentOffset() == 50000 * 10 - 100);
+    REQUIRE(boundRows(view).contains("49999"));
+
+    model.setRowCount(5);
+    REQUIRE(view.contentOffset() == 0);
+    REQUIRE(boundRows(view) == std::set<std::string>{"0", "1", "2", "3", "4"});
+}
@@ -0,0 +1,78 @@
+#include <muui/font.h>
+#include <muui/pixmap.h>
+#include <muui/textureatlas.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <string_view>
+
+using namespace muui;
+using namespace std::string_view_literals;
+
+namespace
+{
+
+constexpr auto FontPath = ASSETSDIR "OpenSans_Bold.ttf";
+
+const unsigned char *glyphTexel(const TextureAtlas &textureAtlas, const Font::Glyph *glyph, int x, int y)
+{
+    const auto &pixmap = textureAtlas.page(0).pixmap();
+    const auto left = static_cast<int>(glyph->pixmap.texCoord.min.x * pixmap.width + 0.5f);
+    const auto top = static_cast<int>(glyph->pixmap.texCoord.min.y * pixmap.height + 0.5f);
+    return pixmap.pixels.data() + ((top + y) * pixmap.width + left + x) * pixelSizeInBytes(pixmap.pixelType);
+}
+
+int median(const unsigned char *rgb)
+{
+    return std::max(std::min(rgb[0], rgb[1]), std::min(std::max(rgb[0], rgb[1]), rgb[2]));
+}
+
+} // namespace
+
+TEST_CASE("Multi-channel distance field glyphs", "[msdf]")
+{
+    TextureAtlas sdfAtlas(1024, 1024);
+    Font sdf(&sdfAtlas);
+    REQUIRE(sdf.loadDistanceField(FontPath));
+
+    TextureAtlas msdfAtlas(1024, 1024);
+    Font msdf(&msdfAtlas);
+    REQUIRE(msdf.loadDistanceField(FontPath, Font::DistanceField::MultiChannel));
+    REQUIRE(msdf.distanceField() == Font::DistanceField::MultiChannel);
+
+    Font scaled(&msdfAtlas);
+    REQUIRE(scaled.load(&msdf, 200));
+    REQUIRE(scaled.distanceField() == Font::DistanceField::MultiChannel);
+
+    for (const auto codepoint : U"AHMOVWkx&@ "sv)
+    {
+        const auto *sdfGlyph = sdf.glyph(codepoint);
+        const auto *msdfGlyph = msdf.glyph(codepoint);
+        REQUIRE(msdfGlyph != nullptr);
+        REQUIRE(msdfGlyph->boundingBox == sdfGlyph->boundingBox);
+        REQUIRE(msdfGlyph->pixmap.texture != sdfGlyph->pixmap.texture);
+        REQUIRE(scaled.glyph(codepoint)->pixmap.texCoord == msdfGlyph->pixmap.texCoord);
+
+        // away from the outline, the median agrees with the single channel distance field on which side a texel is
+        int wrongSide = 0;
+        int differentChannels = 0;
+        for (int y = 0; y < msdfGlyph->pixmap.height; ++y)
+        {
+            for (int x = 0; x < msdfGlyph->pixmap.width; ++x)
+            {
+                const auto sdfValue = *glyphTexel(sdfAtlas, sdfGlyph, x, y);
+                const auto *msdfValue = glyphTexel(msdfAtlas, msdfGlyph, x, y);
+                if (std::abs(sdfValue - 128) > 24 && (median(msdfValue) > 128) != (sdfValue > 128))
+                    ++wrongSide;
+                if (msdfValue[0] != msdfValue[1] || msdfValue[1] != msdfValue[2])
+                    ++differentChannels;
+            }
+        }
+        REQUIRE(wrongSide == 0);
+        // smooth contours don't need more than one channel
+        if (codepoint != U' ' && codepoint != U'O')
+            REQUIRE(differentChannels > 0);
+    }
+    REQUIRE(msdfAtlas.page(0).pixmap().pixelType == PixelType::RGB);
+}
@@ -0,0 +1,43 @@
+#include <muui/radixsort.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <random>
+
+using namespace muui;
+
+TEST_CASE("Radix sort", "[radixsort]")
+{
+    std::vector<std::uint64_t> scratch;
+
+    // empty and single element
+    std::vector<std::uint64_t> keys;
+    radixSort(keys, scratch);
+    REQUIRE(keys.empty());
+
+    keys = {42};
+    radixSort(keys, scratch);
+    REQUIRE(keys == std::vector<std::uint64_t>{42});
+
+    // random keys
+    std::mt19937_64 generator(1234);
+    keys.resize(10000);
+    std::generate(keys.begin(), keys.end(), generator);
+    auto expected = keys;
+    std::sort(expected.begin(), expected.end());
+    radixSort(keys, scratch);
+    REQUIRE(keys == expected);
+
+    // keys that only differ in a few digits, so that some passes are skipped
+    for (auto &key : keys)
+        key = (std::uint64_t(generator() % 16) << 40) | (generator() % 1000);
+    expected = keys;
+    std::sort(expected.begin(), expected.end());
+    radixSort(keys, scratch);
+    REQUIRE(keys == expected);
+
+    // already sorted
+    radixSort(keys, scratch);
+    REQUIRE(keys == expected);
+}
@@ -0,0 +1,58 @@
+#include <muui/font.h>
+#include <muui/textlayout.h>
+#include <muui/textureatlas.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string_view>
+
+using namespace muui;
+using namespace std::string_view_literals;
+
+namespace
+{
+constexpr auto FontPath = ASSETSDIR "OpenSans_Bold.ttf";
+}
+
+TEST_CASE("Text layout", "[textlayout]")
+{
+    TextureAtlas textureAtlas(1024, 1024);
+    Font font(&textureAtlas);
+    REQUIRE(font.load(FontPath, 40));
+
+    TextLayout layout;
+    REQUIRE(layout.isEmpty());
+    layout.setFont(&font);
+
+    const auto pos = glm::vec2(10, 20);
+    layout.addText(U"Hey"sv, pos);
+    layout.addText(U"you"sv, pos + glm::vec2(0, font.pixelHeight()));
+    REQUIRE(layout.glyphs().size() == 6);
+
+    // glyphs are placed like Painter::drawText() places them
+    auto basePos = pos + glm::vec2(0, font.ascent());
+    for (const auto [index, codepoint] : {std::pair{0, U'H'}, std::pair{1, U'e'}, std::pair{2, U'y'}})
+    {
+        const auto *glyph = font.glyph(codepoint);
+        const auto &quad = layout.glyphs()[index];
+        REQUIRE(quad.rect == glyph->boundingBox + basePos);
+        REQUIRE(quad.texCoord == glyph->pixmap.texCoord);
+        REQUIRE(quad.texture == glyph->pixmap.texture);
+        basePos.x += glyph->advanceWidth;
+    }
+    REQUIRE(layout.glyphs()[3].rect == font.glyph(U'y')->boundingBox + pos +
+                                           glm::vec2(0, font.pixelHeight() + font.ascent()));
+    auto bounds = layout.glyphs()[0].rect;
+    for (const auto &quad : layout.glyphs())
+        bounds |= quad.rect;
+    REQUIRE(layout.bounds() == bounds);
+
+    layout.setFont(&font);
+    REQUIRE(layout.glyphs().size() == 6);
+
+    Font otherFont(&textureAtlas);
+    REQUIRE(otherFont.load(FontPath, 20));
+    layout.setFont(&otherFont);
+    REQUIRE(layout.isEmpty());
+    REQUIRE(layout.bounds() == RectF{});
+}
@@ -0,0 +1,67 @@
+#include <muui/item.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace muui;
+
+namespace
+{
+
+class Target : public Rectangle
+{
+public:
+    using Rectangle::Rectangle;
+
+protected:
+    Item *handleMouseEvent(const TouchEvent &event) override
+    {
+        return rect().contains(event.position) ? this : nullptr;
+    }
+};
+
+constexpr auto TargetSize = 10.0f;
+
+void populate(Rectangle &canvas, int count)
+{
+    const auto columns = static_cast<int>(std::ceil(std::sqrt(count)));
+    canvas.setSize(columns * TargetSize, columns * TargetSize);
+    for (int i = 0; i < count; ++i)
+    {
+        auto *target = canvas.appendChild<Target>(TargetSize, TargetSize);
+        target->setLeft(Length::pixels((i % columns) * TargetSize));
+        target->setTop(Length::pixels((i / columns) * TargetSize));
+    }
+}
+
+} // namespace
+
+TEST_CASE("Hit test", "[benchmark]")
+{
+    for (const int count : {100, 1000, 10000})
+    {
+        Rectangle canvas{0, 0};
+        populate(canvas, count);
+
+        std::mt19937 generator(1234);
+        std::uniform_real_distribution<float> distribution(0.0f, canvas.width());
+        std::vector<glm::vec2> positions(256);
+        for (auto &position : positions)
+            position = glm::vec2(distribution(generator), distribution(generator));
+
+        // build the bounds and the grid outside of the measured loop
+        canvas.mouseEvent({TouchEvent::Type::Press, positions.front()});
+
+        BENCHMARK("mouseEvent " + std::to_string(count))
+        {
+            Item *hit = nullptr;
+            for (const auto &position : positions)
+                hit = canvas.mouseEvent({TouchEvent::Type::Press, position});
+            return hit;
+        };
+    }
+}
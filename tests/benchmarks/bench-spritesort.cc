@@ -0,0 +1,79 @@
+#include <muui/radixsort.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace muui;
+
+namespace
+{
+
+// Mirrors the sprite state that SpriteBatcher used to sort on, plus the vertex payload that made every comparison
+// chase a pointer to a large struct.
+struct Sprite
+{
+    int program;
+    const void *texture;
+    const void *gradientTexture;
+    std::array<float, 48> vertices;
+    int depth;
+    std::uint64_t sortKey;
+};
+
+std::vector<Sprite> generateSprites(std::size_t count)
+{
+    static const std::array<int, 8> textures{};
+    std::mt19937 generator(1234);
+    std::vector<Sprite> sprites(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto &sprite = sprites[i];
+        sprite.program = generator() % 4;
+        sprite.texture = &textures[generator() % textures.size()];
+        sprite.gradientTexture = nullptr;
+        sprite.depth = generator() % 64;
+        // same layout as SpriteBatcher: depth | state id | submission order
+        const auto stateId = static_cast<std::uint64_t>(sprite.program) * textures.size() +
+                             (static_cast<const int *>(sprite.texture) - textures.data());
+        sprite.sortKey = (static_cast<std::uint64_t>(sprite.depth) << 40) | (stateId << 19) | i;
+    }
+    return sprites;
+}
+
+} // namespace
+
+TEST_CASE("Sprite sort", "[benchmark]")
+{
+    for (const std::size_t count : {1000, 10000, 100000})
+    {
+        const auto sprites = generateSprites(count);
+
+        std::vector<const Sprite *> sortedSprites(count);
+        BENCHMARK("std::stable_sort " + std::to_string(count))
+        {
+            std::transform(sprites.begin(), sprites.end(), sortedSprites.begin(),
+                           [](const Sprite &sprite) { return &sprite; });
+            std::stable_sort(sortedSprites.begin(), sortedSprites.end(), [](const Sprite *a, const Sprite *b) {
+                return std::tie(a->depth, a->texture, a->gradientTexture, a->program) <
+                       std::tie(b->depth, b->texture, b->gradientTexture, b->program);
+            });
+            return sortedSprites.front();
+        };
+
+        std::vector<std::uint64_t> sortKeys(count);
+        std::vector<std::uint64_t> scratch;
+        BENCHMARK("radixSort " + std::to_string(count))
+        {
+            std::transform(sprites.begin(), sprites.end(), sortKeys.begin(),
+                           [](const Sprite &sprite) { return sprite.sortKey; });
+            radixSort(sortKeys, scratch);
+            return sortKeys.front();
+        };
+    }
+}
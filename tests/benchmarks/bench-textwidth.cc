@@ -0,0 +1,43 @@
+#include <muui/font.h>
+#include <muui/textureatlas.h>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <random>
+#include <string>
+
+using namespace muui;
+
+namespace
+{
+
+// mostly ASCII, with some accented Latin and punctuation from outside of Latin-1
+std::u32string generateText(std::size_t length)
+{
+    const std::u32string alphabet = U"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,;:!?éü—…";
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<std::size_t> distribution(0, alphabet.size() - 1);
+    std::u32string text(length, U' ');
+    for (auto &ch : text)
+        ch = alphabet[distribution(generator)];
+    return text;
+}
+
+} // namespace
+
+TEST_CASE("Text width", "[benchmark]")
+{
+    TextureAtlas textureAtlas(1024, 1024);
+    Font font(&textureAtlas);
+    REQUIRE(font.load(ASSETSDIR "OpenSans_Bold.ttf", 40));
+
+    const auto text = generateText(1 << 20);
+    // rasterize the glyphs outside of the measured loop
+    REQUIRE(font.textWidth(text) > 0.0f);
+
+    BENCHMARK("textWidth 1M characters")
+    {
+        return font.textWidth(text);
+    };
+}
@@ -37,9 +37,9 @@ bool LayoutTest::initialize()
     auto addLabel = [this](muui::Item *parent, std::u32string_view text, muui::AlignmentFlags alignment) {
         auto *label = parent->appendChild<muui::Label>(m_font.get(), text);
         label->setContainerAlignment(alignment);
-        label->fillBackground = true;
-        label->backgroundBrush = glm::vec4{1, 0, 0, 1};
-        label->foregroundBrush = glm::vec4{1, 1, 1, 1};
+        label->setFillBackground(true);
+        label->setBackgroundBrush(glm::vec4{1, 0, 0, 1});
+        label->setForegroundBrush(glm::vec4{1, 1, 1, 1});
     };
 
     auto root = std::make_unique<muui::Column>();
@@ -48,11 +48,11 @@ bool LayoutTest::initialize()
     {
         auto *column = root->appendChild<muui::Column>();
         column->setMinimumWidth(400);
-        column->shape = muui::Item::Shape::RoundedRectangle;
-        column->fillBackground = true;
-        column->backgroundBrush = glm::vec4{0.75, 0.75, 0.75, 1};
+        column->setShape(muui::Item::Shape::RoundedRectangle);
+        column->setFillBackground(true);
+        column->setBackgroundBrush(glm::vec4{0.75, 0.75, 0.75, 1});
         column->setMargins(muui::Margins{8, 8, 8, 8});
-        column->cornerRadius = 8.0f;
+        column->setCornerRadius(8.0f);
         column->setSpacing(4);
         addLabel(column, U"label 1"sv, muui::Alignment::VCenter | muui::Alignment::Left);
         addLabel(column, U"label 2"sv, muui::Alignment::VCenter | muui::Alignment::HCenter);
@@ -62,11 +62,11 @@ bool LayoutTest::initialize()
     {
         auto *row = root->appendChild<muui::Row>();
         row->setMinimumHeight(150);
-        row->shape = muui::Item::Shape::RoundedRectangle;
-        row->fillBackground = true;
-        row->backgroundBrush = glm::vec4{0.75, 0.75, 0.75, 1};
+        row->setShape(muui::Item::Shape::RoundedRectangle);
+        row->setFillBackground(true);
+        row->setBackgroundBrush(glm::vec4{0.75, 0.75, 0.75, 1});
         row->setMargins(muui::Margins{8, 8, 8, 8});
-        row->cornerRadius = 8.0f;
+        row->setCornerRadius(8.0f);
         row->setSpacing(4);
         addLabel(row, U"label 1"sv, muui::Alignment::Top | muui::Alignment::Left);
         addLabel(row, U"label 2"sv, muui::Alignment::VCenter | muui::Alignment::Left);
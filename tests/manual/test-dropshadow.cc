@@ -55,7 +55,7 @@ bool DropShadowTest::initialize()
     rootItem->setSpacing(12);
 
     auto *item = rootItem->appendChild<muui::Label>(m_font.get(), U"Sphinx of black quartz"sv);
-    item->foregroundBrush = glm::vec4(1);
+    item->setForegroundBrush(glm::vec4(1));
 
     auto applyDropShadow = [](auto *item) {
         auto dropShadow = std::make_unique<muui::DropShadow>();
@@ -67,7 +67,7 @@ bool DropShadowTest::initialize()
 
     auto *enableEffect = rootItem->appendChild<muui::Switch>(60.0f, 30.0f);
     enableEffect->setChecked(true);
-    enableEffect->backgroundBrush = glm::vec4{0.5, 0.5, 0.5, 1};
+    enableEffect->setBackgroundBrush(glm::vec4{0.5, 0.5, 0.5, 1});
     enableEffect->toggledSignal.connect([this, applyDropShadow, item](bool checked) {
         if (checked)
         {
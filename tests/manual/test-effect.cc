@@ -117,14 +117,14 @@ bool EffectTest::initialize()
     m_innerContainer->setMargins(muui::Margins{1, 1, 1, 1});
 
     auto *innerColumn = m_innerContainer->appendChild<muui::Column>();
-    innerColumn->fillBackground = true;
-    innerColumn->backgroundBrush = glm::vec4{1, 1, 1, 0.75};
+    innerColumn->setFillBackground(true);
+    innerColumn->setBackgroundBrush(glm::vec4{1, 1, 1, 0.75});
     innerColumn->setMargins(muui::Margins{12, 12, 12, 12});
-    innerColumn->shape = muui::Item::Shape::RoundedRectangle;
-    innerColumn->cornerRadius = 12.0f;
+    innerColumn->setShape(muui::Item::Shape::RoundedRectangle);
+    innerColumn->setCornerRadius(12.0f);
 
     auto *label = innerColumn->appendChild<muui::Label>(m_bigFont.get(), U"Sphinx of black quartz"sv);
-    label->foregroundBrush = glm::vec4(rgbToColor(0x040a18), 1);
+    label->setForegroundBrush(glm::vec4(rgbToColor(0x040a18), 1));
 
     auto *bottomRow = innerColumn->appendChild<muui::Row>();
 
@@ -132,16 +132,16 @@ bool EffectTest::initialize()
     text->setFixedWidth(500);
     text->setText(
         U"Lorem ipsum dolor sit amet, consectetur adipiscing elit. Donec a semper quam. Donec tempor bibendum nulla a viverra. Aenean non urna sit amet dolor hendrerit efficitur vitae dapibus ante. Vestibulum et hendrerit metus. Integer ornare, purus vel ultricies porta, nisl ligula vehicula quam, faucibus malesuada diam risus id lacus. Donec velit nisl, cursus id enim at, sagittis bibendum enim. Phasellus elementum quam eu ultrices rhoncus. Pellentesque vel dui id turpis euismod consequat. Fusce ac aliquam nibh. Mauris laoreet tincidunt sem eget varius."sv);
-    text->foregroundBrush = glm::vec4(rgbToColor(0x040a18), 1);
+    text->setForegroundBrush(glm::vec4(rgbToColor(0x040a18), 1));
 
     auto *image = bottomRow->appendChild<muui::Image>((AssetsPath / "vim.png").string());
-    image->foregroundBrush = glm::vec4{1};
+    image->setForegroundBrush(glm::vec4{1});
 
     m_innerContainer->setShaderEffect(std::make_unique<TransitionEffect>());
 
     auto *direction = rootItem->appendChild<muui::Switch>(60.0f, 30.0f);
     direction->setChecked(true);
-    direction->backgroundBrush = glm::vec4{0.5, 0.5, 0.5, 1};
+    direction->setBackgroundBrush(glm::vec4{0.5, 0.5, 0.5, 1});
     direction->toggledSignal.connect([this](bool checked) {
         if (checked)
             m_direction = 1.0f;
@@ -151,7 +151,7 @@ bool EffectTest::initialize()
 
     auto *enableEffect = rootItem->appendChild<muui::Switch>(60.0f, 30.0f);
     enableEffect->setChecked(true);
-    enableEffect->backgroundBrush = glm::vec4{0.5, 0.5, 0.5, 1};
+    enableEffect->setBackgroundBrush(glm::vec4{0.5, 0.5, 0.5, 1});
     enableEffect->toggledSignal.connect([this](bool checked) {
         if (checked)
         {
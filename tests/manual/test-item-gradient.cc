@@ -45,17 +45,17 @@ bool LayoutTest::initialize()
         const muui::LinearGradient gradient = {
             .texture = m_gradientTexture.get(), .start = glm::vec2(0, 0), .end = glm::vec2(0, 1)};
         auto *rect = parent->appendChild<muui::Rectangle>(width, height);
-        rect->fillBackground = true;
-        rect->backgroundBrush = gradient;
+        rect->setFillBackground(true);
+        rect->setBackgroundBrush(gradient);
     };
 
     auto addLabel = [this](muui::Item *parent, std::u32string_view text) {
         const muui::LinearGradient gradient = {
             .texture = m_gradientTexture.get(), .start = glm::vec2(0, 0.2), .end = glm::vec2(0, 0.8)};
         auto *label = parent->appendChild<muui::Label>(m_font.get(), text);
-        label->fillBackground = true;
-        label->backgroundBrush = glm::vec4{1, 0, 0, 1};
-        label->foregroundBrush = gradient;
+        label->setFillBackground(true);
+        label->setBackgroundBrush(glm::vec4{1, 0, 0, 1});
+        label->setForegroundBrush(gradient);
     };
 
     auto root = std::make_unique<muui::Column>();
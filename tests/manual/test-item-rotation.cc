@@ -62,9 +62,9 @@ bool ItemRotationTest::initialize()
         const muui::LinearGradient gradient = {
             .texture = m_gradientTexture.get(), .start = glm::vec2(0, 0), .end = glm::vec2(0, 1)};
         auto *button = parent->appendChild<muui::Button>(m_font.get(), text);
-        button->foregroundBrush = glm::vec4{1};
-        button->backgroundBrush = gradient;
-        button->fillBackground = true;
+        button->setForegroundBrush(glm::vec4{1});
+        button->setBackgroundBrush(gradient);
+        button->setFillBackground(true);
         button->setMargins(muui::Margins{4, 4, 4, 4});
         button->setFixedWidth(200);
         button->setFixedHeight(60);
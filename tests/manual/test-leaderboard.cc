@@ -4,15 +4,19 @@
 #include <muui/font.h>
 #include <muui/item.h>
 #include <muui/painter.h>
+#include <muui/renderstatsoverlay.h>
 #include <muui/screen.h>
+#include <muui/spritebatcher.h>
 #include <muui/textureatlas.h>
 
 #include <fmt/core.h>
 #include <fmt/xchar.h>
 
+#include <array>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace std::string_literals;
 using namespace std::string_view_literals;
@@ -30,21 +34,125 @@ constexpr glm::vec3 rgbToColor(unsigned color)
     return (1.0f / 255.0f) * glm::vec3(r, g, b);
 }
 
-void buildUI(Item *rootItem, Font *smallFont, Font *bigFont)
+constexpr auto headingColor = rgbToColor(0x04568e);
+constexpr auto textColor = rgbToColor(0x040a18);
+constexpr auto outerMargin = 40;
+constexpr auto rowMargin = 10;
+constexpr auto indexColumnWidth = 40;
+constexpr auto scoreColumnWidth = 300;
+constexpr auto accuracyColumnWidth = 300;
+
+struct Entry
+{
+    std::u32string name;
+    int score;
+    float accuracy;
+};
+
+std::vector<Entry> generateEntries(std::size_t count)
+{
+    static const std::vector<const char32_t *> names = {U"ALICE", U"BOB",  U"CHARLIE", U"DAVID", U"EVE",
+                                                        U"FRANK", U"GINA", U"HARRIET", U"IVAN"};
+    std::vector<Entry> entries;
+    entries.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Entry entry;
+        entry.name = names[i % names.size()];
+        entry.score = std::rand();
+        entry.accuracy = 100.0f * static_cast<float>(std::rand()) / RAND_MAX;
+        entries.push_back(entry);
+    }
+    std::ranges::sort(entries, [](const auto &lhs, const auto &rhs) { return lhs.score > rhs.score; });
+    return entries;
+}
+
+std::u32string formatThousands(int value)
+{
+    std::u32string text;
+    while (value)
+    {
+        auto s = fmt::format(value >= 1000 ? U"{:03}" : U"{}", value % 1000);
+        if (text.empty())
+            text = std::move(s);
+        else
+            text = s + U"," + text;
+        value /= 1000;
+    }
+    return text;
+}
+
+class LeaderboardModel : public ListModel
+{
+public:
+    LeaderboardModel(Font *font, std::vector<Entry> entries)
+        : m_font(font)
+        , m_entries(std::move(entries))
+    {
+    }
+
+    void setNameColumnWidth(float width) { m_nameColumnWidth = width; }
+
+    std::size_t rowCount() const override { return m_entries.size(); }
+
+    std::unique_ptr<Item> createDelegate() override
+    {
+        auto row = std::make_unique<Row>();
+        row->setFillBackground(true);
+        row->setShape(Item::Shape::RoundedRectangle);
+        row->setCornerRadius(8);
+        row->setBackgroundBrush(glm::vec4{1, 1, 1, 0.75});
+        row->setMargins(Margins{rowMargin, rowMargin, rowMargin, rowMargin});
+        row->setSpacing(1);
+
+        auto *index = row->appendChild<Label>(m_font);
+        index->setForegroundBrush(glm::vec4{textColor, 1.0f});
+        index->setFixedWidth(indexColumnWidth);
+
+        auto *nameLabel = row->appendChild<Label>(m_font);
+        nameLabel->setForegroundBrush(glm::vec4{headingColor, 1.0f});
+        nameLabel->setFixedWidth(m_nameColumnWidth);
+
+        auto *scoreLabel = row->appendChild<Label>(m_font);
+        scoreLabel->setForegroundBrush(glm::vec4{textColor, 1.0f});
+        scoreLabel->setFixedWidth(scoreColumnWidth);
+        scoreLabel->setAlignment(Alignment::HCenter);
+
+        auto *accuracyLabel = row->appendChild<Label>(m_font);
+        accuracyLabel->setForegroundBrush(glm::vec4{textColor, 1.0f});
+        accuracyLabel->setFixedWidth(accuracyColumnWidth);
+        accuracyLabel->setAlignment(Alignment::Right);
+
+        return row;
+    }
+
+    void bindDelegate(Item *delegate, std::size_t row) override
+    {
+        const auto &entry = m_entries[row];
+        const auto label = [delegate](std::size_t index) { return static_cast<Label *>(delegate->childAt(index)); };
+        label(0)->setText(fmt::format(U"{}.", row + 1));
+        label(1)->setText(entry.name);
+        label(2)->setText(formatThousands(entry.score));
+        label(3)->setText(fmt::format(U"{:.2f}%", entry.accuracy));
+    }
+
+private:
+    Font *m_font;
+    std::vector<Entry> m_entries;
+    float m_nameColumnWidth = 0.0f;
+};
+
+void buildUI(Item *rootItem, Font *smallFont, Font *bigFont, LeaderboardModel *model)
 {
     const auto width = rootItem->width();
     const auto height = rootItem->height();
 
-    constexpr auto headingColor = rgbToColor(0x04568e);
-    constexpr auto textColor = rgbToColor(0x040a18);
-    constexpr auto outerMargin = 40;
-
     auto outerContainer = rootItem->appendChild<Column>();
     outerContainer->setMargins(Margins{outerMargin, outerMargin, outerMargin, outerMargin});
     outerContainer->setSpacing(5);
 
     auto *title = outerContainer->appendChild<Label>(bigFont, U"TODAY'S HEROES"sv);
-    title->foregroundBrush = glm::vec4{headingColor, 1};
+    title->setForegroundBrush(glm::vec4{headingColor, 1});
     title->setContainerAlignment(Alignment::VCenter | Alignment::HCenter);
 
     auto *innerContainer = outerContainer->appendChild<Column>();
@@ -52,11 +160,6 @@ void buildUI(Item *rootItem, Font *smallFont, Font *bigFont)
     innerContainer->setSpacing(5);
 
     {
-        constexpr auto rowMargin = 10;
-
-        constexpr auto indexColumnWidth = 40;
-        constexpr auto scoreColumnWidth = 300;
-        constexpr auto accuracyColumnWidth = 300;
         const auto nameColumnWidth = [=] {
             const auto columnCount = 4;
             const auto usedWidth = 2 * outerMargin + 2 * rowMargin + indexColumnWidth + scoreColumnWidth +
@@ -64,10 +167,10 @@ void buildUI(Item *rootItem, Font *smallFont, Font *bigFont)
             return width - usedWidth;
         }();
 
-        auto appendSeparator = [&textColor](Item *parent) {
+        auto appendSeparator = [](Item *parent) {
             auto *r = parent->appendChild<Rectangle>();
-            r->fillBackground = true;
-            r->backgroundBrush = glm::vec4{textColor, 0.25};
+            r->setFillBackground(true);
+            r->setBackgroundBrush(glm::vec4{textColor, 0.25});
             r->setSize(1, 30);
         };
 
@@ -80,7 +183,7 @@ void buildUI(Item *rootItem, Font *smallFont, Font *bigFont)
 
         {
             auto *l = headerRow->appendChild<Label>(smallFont, U"NAME"sv);
-            l->foregroundBrush = glm::vec4{textColor, 1.0f};
+            l->setForegroundBrush(glm::vec4{textColor, 1.0f});
             l->setAlignment(Alignment::Left);
             l->setFixedWidth(nameColumnWidth);
         }
@@ -89,7 +192,7 @@ void buildUI(Item *rootItem, Font *smallFont, Font *bigFont)
 
         {
             auto *l = headerRow->appendChild<Label>(smallFont, U"SCORE"sv);
-            l->foregroundBrush = glm::vec4{textColor, 1.0f};
+            l->setForegroundBrush(glm::vec4{textColor, 1.0f});
             l->setAlignment(Alignment::HCenter);
             l->setFixedWidth(scoreColumnWidth);
         }
@@ -98,7 +201,7 @@ void buildUI(Item *rootItem, Font *smallFont, Font *bigFont)
 
         {
             auto *l = headerRow->appendChild<Label>(smallFont, U"ACCURACY"sv);
-            l->foregroundBrush = glm::vec4{textColor, 1.0f};
+            l->setForegroundBrush(glm::vec4{textColor, 1.0f});
             l->setAlignment(Alignment::Right);
             l->setFixedWidth(accuracyColumnWidth);
         }
@@ -110,87 +213,18 @@ void buildUI(Item *rootItem, Font *smallFont, Font *bigFont)
 
         assert(headerRow->width() == width - 2 * outerMargin);
 
-        // entries column
+        // entries, only the visible rows are instantiated
 
-        auto entryColumn = std::make_unique<Column>();
-        entryColumn->setSpacing(5);
-
-        struct Entry
-        {
-            std::u32string name;
-            int score;
-            float accuracy;
-        };
-        static std::vector<Entry> entries = [] {
-            static std::vector<const char32_t *> names = {U"ALICE", U"BOB",  U"CHARLIE", U"DAVID", U"EVE",
-                                                          U"FRANK", U"GINA", U"HARRIET", U"IVAN"};
-            std::vector<Entry> entries;
-            for (const auto *name : names)
-            {
-                Entry entry;
-                entry.name = name;
-                entry.score = std::rand();
-                entry.accuracy = 100.0f * static_cast<float>(std::rand()) / RAND_MAX;
-                entries.push_back(entry);
-            }
-            std::ranges::sort(entries, [](const auto &lhs, const auto &rhs) { return lhs.score > rhs.score; });
-            return entries;
-        }();
-
-        for (std::size_t i = 0; i < entries.size(); ++i)
-        {
-            const auto &entry = entries[i];
-
-            auto *row = entryColumn->appendChild<Row>();
-            row->fillBackground = true;
-            row->shape = Item::Shape::RoundedRectangle;
-            row->cornerRadius = 8;
-            row->backgroundBrush = glm::vec4{1, 1, 1, 0.75};
-            row->setMargins(Margins{rowMargin, rowMargin, rowMargin, rowMargin});
-            row->setSpacing(1);
-
-            auto *index = row->appendChild<Label>(smallFont, fmt::format(U"{}.", i + 1));
-            index->foregroundBrush = glm::vec4{textColor, 1.0f};
-            index->setFixedWidth(indexColumnWidth);
-
-            auto *nameLabel = row->appendChild<Label>(smallFont, entry.name);
-            nameLabel->foregroundBrush = glm::vec4{headingColor, 1.0f};
-            nameLabel->setFixedWidth(nameColumnWidth);
-
-            auto formatThousands = [](int value) -> std::u32string {
-                std::u32string text;
-                while (value)
-                {
-                    auto s = fmt::format(value >= 1000 ? U"{:03}" : U"{}", value % 1000);
-                    if (text.empty())
-                        text = std::move(s);
-                    else
-                        text = s + U"," + text;
-                    value /= 1000;
-                }
-                return text;
-            };
-
-            auto *scoreLabel = row->appendChild<Label>(smallFont, formatThousands(entry.score));
-            scoreLabel->foregroundBrush = glm::vec4{textColor, 1.0f};
-            scoreLabel->setFixedWidth(scoreColumnWidth);
-            scoreLabel->setAlignment(Alignment::HCenter);
-
-            auto *accuracyLabel = row->appendChild<Label>(smallFont, fmt::format(U"{:.2f}%", entry.accuracy));
-            accuracyLabel->foregroundBrush = glm::vec4{textColor, 1.0f};
-            accuracyLabel->setFixedWidth(accuracyColumnWidth);
-            accuracyLabel->setAlignment(Alignment::Right);
-        }
-
-        assert(entryColumn->width() == width - 2 * outerMargin);
+        model->setNameColumnWidth(nameColumnWidth);
 
         const auto containerHeight = height - 2 * outerMargin - (title->height() + outerContainer->spacing());
 
-        const auto viewportWidth = entryColumn->width();
+        const auto viewportWidth = headerRow->width();
         const auto viewportHeight = containerHeight - (headerRow->height() + innerContainer->spacing());
 
-        auto *scrollArea = innerContainer->appendChild<ScrollArea>(std::move(entryColumn));
-        scrollArea->setViewportSize({viewportWidth, viewportHeight});
+        auto *listView = innerContainer->appendChild<ListView>(model);
+        listView->setSpacing(5);
+        listView->setViewportSize({viewportWidth, viewportHeight});
 
         assert(innerContainer->width() == viewportWidth);
         assert(innerContainer->height() == containerHeight);
@@ -208,12 +242,15 @@ public:
     bool initialize() override;
     void resize(int width, int height) override;
     void render() const override;
+    void update(float elapsed) override;
     void handleTouchEvent(TouchAction action, int x, int y) override;
 
 private:
     std::unique_ptr<TextureAtlas> m_textureAtlas;
-    std::unique_ptr<Font> m_smallFont, m_bigFont;
+    std::unique_ptr<Font> m_smallFont, m_bigFont, m_statsFont;
     std::unique_ptr<Screen> m_screen;
+    std::unique_ptr<LeaderboardModel> m_model;
+    RenderStatsOverlay *m_statsOverlay = nullptr;
 };
 
 bool LeaderboardTest::initialize()
@@ -227,8 +264,22 @@ bool LeaderboardTest::initialize()
     m_bigFont = std::make_unique<Font>(m_textureAtlas.get());
     if (!m_bigFont->load(fontPath, 70))
         panic("Failed to load font\n");
+    m_statsFont = std::make_unique<Font>(m_textureAtlas.get());
+    if (!m_statsFont->load(fontPath, 16))
+        panic("Failed to load font\n");
+
+    // scrolling brings up new names and scores, have their glyphs ready before the first frame needs them
+    constexpr std::array PrintableAscii = {Font::CodepointRange{U' ', U'~'}};
+    m_smallFont->preload(PrintableAscii);
+
+    constexpr auto EntryCount = 50000;
+    m_model = std::make_unique<LeaderboardModel>(m_smallFont.get(), generateEntries(EntryCount));
 
     m_screen = std::make_unique<Screen>();
+    m_screen->m_painter->spriteBatcher()->setBatchMergingEnabled(true);
+    m_screen->m_painter->spriteBatcher()->setDepthTestEnabled(true);
+    m_screen->m_painter->spriteBatcher()->setMultiTextureEnabled(true);
+    m_screen->setPartialUpdatesEnabled(true);
 
     return true;
 }
@@ -237,9 +288,18 @@ void LeaderboardTest::resize(int width, int height)
 {
     m_screen->setSize(static_cast<float>(width), static_cast<float>(height));
 
-    if (m_screen->childCount() > 0)
+    while (m_screen->childCount() > 0)
         m_screen->removeChild(0);
-    buildUI(m_screen.get(), m_smallFont.get(), m_bigFont.get());
+    buildUI(m_screen.get(), m_smallFont.get(), m_bigFont.get(), m_model.get());
+    m_statsOverlay = m_screen->appendChild<RenderStatsOverlay>(m_statsFont.get());
+}
+
+void LeaderboardTest::update(float elapsed)
+{
+    m_smallFont->commitPreloadedGlyphs();
+    if (m_statsOverlay)
+        m_statsOverlay->setStats(renderStats(), framesPerSecond());
+    m_screen->update(elapsed);
 }
 
 void LeaderboardTest::render() const
@@ -47,15 +47,17 @@ bool ScrollAreaTest::initialize()
     m_screen = std::make_unique<muui::Screen>();
 
     auto label = std::make_unique<muui::Label>(m_font.get(), U"Sphinx of black quartz"sv);
-    label->foregroundBrush = glm::vec4{1};
-    label->backgroundBrush = glm::vec4{1, 0, 0, 1};
-    label->fillBackground = true;
+    label->setForegroundBrush(glm::vec4{1});
+    label->setBackgroundBrush(glm::vec4{1, 0, 0, 1});
+    label->setFillBackground(true);
 
     auto *scrollArea = m_screen->appendChild<muui::ScrollArea>(std::move(label));
     scrollArea->setLeft(muui::Length::pixels(50));
     scrollArea->setTop(muui::Length::pixels(50));
     scrollArea->setViewportSize(muui::Size{150, 150});
 
+    setRenderOnDemand(true);
+
     return true;
 }
 